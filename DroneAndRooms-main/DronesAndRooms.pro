@@ -2,30 +2,56 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+QT += concurrent
+
 CONFIG += c++17
 
+# the kinematics of the drones (DroneSystem) is vectorized by the compiler only if
+# sqrt and the comparisons of floats can be computed on all the lanes without branch
+gcc|clang: QMAKE_CXXFLAGS += -fno-math-errno -fno-trapping-math
+
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    benchmark.cpp \
     canvas.cpp \
+    congestion.cpp \
+    contractionhierarchy.cpp \
     determinant.cpp \
+    dronesystem.cpp \
+    landmarkrouter.cpp \
     main.cpp \
     mainwindow.cpp \
     polygon.cpp \
+    predicates.cpp \
+    routing.cpp \
     serveranddrone.cpp \
+    shortestpath.cpp \
+    simulationclock.cpp \
     trianglemesh.cpp \
-    vector2d.cpp
+    vector2d.cpp \
+    voronoi.cpp
 
 HEADERS += \
+    benchmark.h \
     canvas.h \
+    congestion.h \
+    contractionhierarchy.h \
     determinant.h \
+    dronesystem.h \
+    landmarkrouter.h \
     mainwindow.h \
     polygon.h \
+    predicates.h \
+    routing.h \
     serveranddrone.h \
+    shortestpath.h \
+    simulationclock.h \
     trianglemesh.h \
-    vector2d.h
+    vector2d.h \
+    voronoi.h
 
 FORMS += \
     mainwindow.ui
@@ -0,0 +1,511 @@
+#include "benchmark.h"
+#include <trianglemesh.h>
+#include <voronoi.h>
+#include <routing.h>
+#include <shortestpath.h>
+#include <congestion.h>
+#include <contractionhierarchy.h>
+#include <landmarkrouter.h>
+#include <dronesystem.h>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+QList<Server> randomServers(int n,int size,quint32 seed) {
+    QRandomGenerator generator(seed);
+    QList<Server> servers;
+    for (int i=0; i<n; i++) {
+        Server s;
+        s.id=i;
+        s.name="S"+QString::number(i);
+        s.position=QPointF(generator.bounded(size),generator.bounded(size));
+        servers.append(s);
+    }
+    return servers;
+}
+
+void benchmarkVoronoi() {
+    qInfo() << "--- Voronoi areas ---";
+    for (int n:{1000,10000,100000}) {
+        // constant density of servers
+        int size=int(100*sqrt(double(n)));
+        QList<Server> servers=randomServers(n,size,n);
+        QElapsedTimer timer;
+
+        timer.start();
+        TriangleMesh mesh(servers);
+        mesh.setBox(QPoint(0,0),QSize(size,size));
+        qint64 meshTime=timer.elapsed();
+
+        timer.restart();
+        VoronoiDiagram voronoi(mesh);
+        voronoi.fillAreas(servers);
+        qint64 indexedTime=timer.elapsed();
+
+        QString scanTime="skipped";
+        if (n<=10000) { // O(n.T) is too slow for larger sets
+            QList<Server> scanServers=randomServers(n,size,n);
+            timer.restart();
+            buildVoronoiAreasByScan(mesh,scanServers);
+            scanTime=QString::number(timer.elapsed())+" ms";
+        }
+        qInfo().noquote() << n << "servers: mesh" << meshTime << "ms, indexed" << indexedTime << "ms, scan" << scanTime;
+    }
+}
+
+namespace {
+/**
+ * @brief countDifferences: number of pairs whose distances differ in the two tables
+ */
+int countDifferences(const QList<Server> &servers,const RoutingTable &a,const RoutingTable &b,const QVector<int> &targets) {
+    int nDiff=0;
+    for (int t:targets) {
+        for (int v=0; v<servers.size(); v++) {
+            float da=a.getDistance(servers,v,t),db=b.getDistance(servers,v,t);
+            if (std::abs(da-db)>1e-4f*(1.0f+std::abs(db))) nDiff++;
+        }
+    }
+    return nDiff;
+}
+
+/**
+ * @brief createNearestLinks: dense graph, each server is linked to its k nearest
+ * servers by a straight link (door at the middle), a server keeps at most
+ * RoutingTable::maxPorts links so that all of them can be next hops
+ */
+QList<Link*> createNearestLinks(QList<Server> &servers,int k) {
+    QList<Link*> links;
+    int n=servers.size();
+    int nNearest=qMin(k+1,n); // the server itself is the first one
+    QVector<int> order(n);
+    for (int a=0; a<n; a++) {
+        const QPointF A=servers[a].position;
+        auto dist2=[&servers,&A](int b) {
+            QPointF d=servers[b].position-A;
+            return d.x()*d.x()+d.y()*d.y();
+        };
+        std::iota(order.begin(),order.end(),0);
+        std::partial_sort(order.begin(),order.begin()+nNearest,order.end(),
+                          [&dist2](int b,int c) { return dist2(b)<dist2(c); });
+        for (int i=0; i<nNearest; i++) {
+            Server *S1=&servers[a], *S2=&servers[order[i]];
+            if (S1==S2 || S1->links.size()>=RoutingTable::maxPorts || S2->links.size()>=RoutingTable::maxPorts) continue;
+            // already linked when a is one of the nearest servers of b
+            bool linked=std::any_of(S1->links.begin(),S1->links.end(),[S2](Link *l) {
+                return l->getNode1()==S2 || l->getNode2()==S2;
+            });
+            if (linked) continue;
+            QPointF M=0.5*(S1->position+S2->position);
+            Vector2D door(M.x(),M.y());
+            Link *l=new Link(S1,S2,QPair<Vector2D,Vector2D>(door,door));
+            links.push_back(l);
+            S1->links.push_back(l);
+            S2->links.push_back(l);
+        }
+    }
+    return links;
+}
+}
+
+void benchmarkRoutingUpdates() {
+    qInfo() << "--- Routing updates ---";
+    for (int n:{1000,2000}) {
+        int size=int(100*sqrt(double(n)));
+        QList<Server> servers=randomServers(n,size,n);
+        TriangleMesh mesh(servers);
+        mesh.setBox(QPoint(0,0),QSize(size,size));
+        VoronoiDiagram voronoi(mesh);
+        voronoi.fillAreas(servers);
+        QList<Link*> links=voronoi.createLinks(servers);
+
+        QVector<int> allTargets(n),someTargets;
+        std::iota(allTargets.begin(),allTargets.end(),0);
+        for (int t=0; t<n; t+=n/20) someTargets.push_back(t);
+
+        for (auto mode:{RoutingTable::Mode::AllPairs,RoutingTable::Mode::TargetTrees}) {
+            bool allPairs=(mode==RoutingTable::Mode::AllPairs);
+            // same sequence of changes for both modes
+            QRandomGenerator generator(n);
+            for (Link *l:links) l->setUp(true);
+            for (auto &s:servers) s.up=true;
+
+            RoutingTable table;
+            QElapsedTimer timer;
+            timer.start();
+            if (allPairs) table.build(servers,true); else table.buildTargets(servers,someTargets);
+            qint64 buildTime=timer.elapsed();
+
+            int nUpdates=0,changed=0;
+            timer.restart();
+            for (int i=0; i<20; i++) { // congestion: cost x0.5 to x2
+                Link *l=links[generator.bounded(int(links.size()))];
+                changed+=table.setLinkDistance(servers,l,l->getDistance()*(0.5+1.5*generator.generateDouble()));
+                nUpdates++;
+            }
+            for (int i=0; i<5; i++) { // maintenance of a link
+                Link *l=links[generator.bounded(int(links.size()))];
+                changed+=table.setLinkUp(servers,l,false);
+                changed+=table.setLinkUp(servers,l,true);
+                nUpdates+=2;
+            }
+            for (int i=0; i<5; i++) { // server offline
+                int id=generator.bounded(n);
+                changed+=table.setServerUp(servers,id,false);
+                nUpdates++;
+            }
+            qint64 updateTime=timer.elapsed();
+
+            RoutingTable reference;
+            timer.restart();
+            if (allPairs) reference.build(servers,true); else reference.buildTargets(servers,someTargets);
+            qint64 rebuildTime=timer.elapsed();
+
+            int nDiff=countDifferences(servers,table,reference,allPairs?allTargets:someTargets);
+            qInfo().noquote() << n << "servers," << (allPairs?"all pairs:":"20 targets:") << "build" << buildTime << "ms,"
+                              << nUpdates << "updates" << updateTime << "ms (" << QString::number(updateTime/double(nUpdates),'f',2)
+                              << "ms each," << changed << "next hops changed), rebuild"
+                              << rebuildTime << "ms, differences" << nDiff;
+        }
+        qDeleteAll(links);
+    }
+}
+
+void benchmarkShortestPaths() {
+    qInfo() << "--- Shortest path trees ---";
+    const int n=100000;
+    int size=int(100*sqrt(double(n)));
+    QList<Server> servers=randomServers(n,size,n);
+    TriangleMesh mesh(servers);
+    mesh.setBox(QPoint(0,0),QSize(size,size));
+    VoronoiDiagram voronoi(mesh);
+    voronoi.fillAreas(servers);
+    QList<Link*> links=voronoi.createLinks(servers);
+
+    const int nSources=20;
+    QVector<qreal> reference(qsizetype(nSources)*n);
+    for (auto queue:{ShortestPathTree::Queue::BinaryHeap,ShortestPathTree::Queue::RadixHeap}) {
+        bool binary=(queue==ShortestPathTree::Queue::BinaryHeap);
+        ShortestPathTree tree(queue);
+        int nDiff=0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int i=0; i<nSources; i++) {
+            tree.run(servers.constData(),n,i*(n/nSources));
+            for (int v=0; v<n; v++) {
+                qreal &d=reference[qsizetype(i)*n+v];
+                if (binary) d=tree.getDistance(v);
+                else if (d!=tree.getDistance(v)) nDiff++;
+            }
+        }
+        qInfo().noquote() << n << "servers," << (binary?"binary heap:":"radix heap:")
+                          << QString::number(timer.elapsed()/double(nSources),'f',1) << "ms per tree, differences" << nDiff;
+    }
+    qDeleteAll(links);
+}
+
+void benchmarkContractionHierarchy() {
+    qInfo() << "--- Contraction hierarchy ---";
+    for (int n:{10000,100000}) {
+        int size=int(100*sqrt(double(n)));
+        QList<Server> servers=randomServers(n,size,n);
+        TriangleMesh mesh(servers);
+        mesh.setBox(QPoint(0,0),QSize(size,size));
+        VoronoiDiagram voronoi(mesh);
+        voronoi.fillAreas(servers);
+        QList<Link*> links=voronoi.createLinks(servers);
+
+        QElapsedTimer timer;
+        timer.start();
+        ContractionHierarchy hierarchy;
+        hierarchy.build(servers);
+        qint64 buildTime=timer.elapsed();
+
+        // reference: one shortest path tree
+        int target=n/2;
+        RoutingTable tree;
+        timer.restart();
+        tree.buildTargets(servers,{target});
+        qint64 dijkstraTime=timer.nsecsElapsed();
+
+        const int nQueries=10000;
+        QRandomGenerator generator(n);
+        QVector<int> sources(nQueries);
+        for (int &s:sources) s=generator.bounded(n);
+        int nDiff=0;
+        timer.restart();
+        for (int s:sources) {
+            float d=hierarchy.getDistance(servers,s,target);
+            if (std::abs(d-tree.getDistance(servers,s,target))>1e-4f*(1.0f+std::abs(d))) nDiff++;
+        }
+        qint64 queryTime=timer.nsecsElapsed();
+        timer.restart();
+        for (int s:sources) hierarchy.getNextLink(servers[s],target);
+        qint64 hopTime=timer.nsecsElapsed();
+
+        qInfo().noquote() << n << "servers: preprocessing" << buildTime << "ms," << hierarchy.getNbShortcuts() << "shortcuts,"
+                          << "distance query" << QString::number(queryTime/1000.0/nQueries,'f',1) << "us,"
+                          << "first hop query" << QString::number(hopTime/1000.0/nQueries,'f',1) << "us,"
+                          << "Dijkstra tree" << QString::number(dijkstraTime/1000.0,'f',0) << "us, differences" << nDiff;
+        qDeleteAll(links);
+    }
+}
+
+void benchmarkLandmarks() {
+    qInfo() << "--- Landmarks (ALT) ---";
+    const int n=200000;
+    int size=int(100*sqrt(double(n)));
+    QList<Server> servers=randomServers(n,size,n);
+    TriangleMesh mesh(servers);
+    mesh.setBox(QPoint(0,0),QSize(size,size));
+    VoronoiDiagram voronoi(mesh);
+    voronoi.fillAreas(servers);
+    QList<Link*> links=voronoi.createLinks(servers);
+
+    int target=n/2;
+    RoutingTable tree;
+    QElapsedTimer timer;
+    timer.start();
+    tree.buildTargets(servers,{target});
+    qint64 dijkstraTime=timer.elapsed();
+
+    const int nQueries=200;
+    for (int k:{4,16}) {
+        LandmarkRouter router;
+        timer.restart();
+        router.build(servers,k);
+        qint64 buildTime=timer.elapsed();
+
+        QRandomGenerator generator(n);
+        int nDiff=0;
+        timer.restart();
+        for (int i=0; i<nQueries; i++) {
+            int s=generator.bounded(n);
+            float d=router.getDistance(servers,s,target);
+            if (std::abs(d-tree.getDistance(servers,s,target))>1e-4f*(1.0f+std::abs(d))) nDiff++;
+        }
+        qint64 queryTime=timer.nsecsElapsed();
+        qInfo().noquote() << n << "servers," << k << "landmarks: preprocessing" << buildTime << "ms,"
+                          << (qsizetype(k)*n*sizeof(float))/(1<<20) << "MB, A* query"
+                          << QString::number(queryTime/1000.0/nQueries,'f',0) << "us, Dijkstra tree"
+                          << dijkstraTime << "ms, differences" << nDiff;
+    }
+    qDeleteAll(links);
+}
+
+void benchmarkCongestion() {
+    qInfo() << "--- Congestion ---";
+    const int n=2000;
+    int size=int(100*sqrt(double(n)));
+    QList<Server> servers=randomServers(n,size,n);
+    TriangleMesh mesh(servers);
+    mesh.setBox(QPoint(0,0),QSize(size,size));
+    VoronoiDiagram voronoi(mesh);
+    voronoi.fillAreas(servers);
+    QList<Link*> links=voronoi.createLinks(servers);
+
+    RoutingTable table;
+    table.build(servers,true);
+    CongestionControl congestion;
+    QRandomGenerator generator(n);
+    const int nTrips=100,nTargets=5;
+    const qreal budget=10; // ms of repair per tick
+    qint64 updateTime=0,maxTickTime=0;
+    int nUpdates=0,changed=0,nTicks=0;
+    for (int period=0; period<10; period++) {
+        // each period, the drones fly from random servers toward a few targets
+        for (int i=0; i<nTrips; i++) {
+            int target=(i%nTargets)*(n/nTargets);
+            for (Link *l:table.getRoute(servers[generator.bounded(n)],target)) l->addCrossing();
+        }
+        QElapsedTimer timer;
+        timer.start();
+        changed+=congestion.update(servers,links,table,10.0);
+        // the repair is spread over the ticks of the simulation
+        bool done=false;
+        while (!done) {
+            QElapsedTimer tickTimer;
+            tickTimer.start();
+            done=table.continueRepair(servers,budget);
+            maxTickTime=qMax(maxTickTime,tickTimer.elapsed());
+            nTicks++;
+        }
+        updateTime+=timer.elapsed();
+        nUpdates++;
+    }
+    RoutingTable reference;
+    QElapsedTimer timer;
+    timer.start();
+    reference.build(servers,true);
+    qint64 rebuildTime=timer.elapsed();
+    QVector<int> allTargets(n);
+    std::iota(allTargets.begin(),allTargets.end(),0);
+    int nCongested=0;
+    for (Link *l:links) {
+        if (l->getDistance()>l->getLength()) nCongested++;
+    }
+    qInfo().noquote() << n << "servers:" << nUpdates << "updates" << updateTime/nUpdates << "ms each, over"
+                      << nTicks/nUpdates << "ticks of at most" << maxTickTime << "ms,"
+                      << nCongested << "congested links," << changed << "link costs changed, rebuild"
+                      << rebuildTime << "ms, differences" << countDifferences(servers,table,reference,allTargets);
+    qDeleteAll(links);
+}
+
+void benchmarkFloydWarshall() {
+    qInfo() << "--- Floyd-Warshall vs Dijkstra (all pairs) ---";
+    // 0: links of the Voronoi areas (sparse), otherwise links to the n/divisor nearest servers
+    for (int divisor:{0,16,4}) {
+        QString graph=divisor ? "links to the n/"+QString::number(divisor)+" nearest servers" : QString("Voronoi links");
+        qInfo().noquote() << graph;
+        int crossover=-1;
+        for (int n:{100,200,400,800,1600}) {
+            int size=int(100*sqrt(double(n)));
+            QList<Server> servers=randomServers(n,size,n);
+            QList<Link*> links;
+            if (divisor) {
+                links=createNearestLinks(servers,n/divisor);
+            } else {
+                TriangleMesh mesh(servers);
+                mesh.setBox(QPoint(0,0),QSize(size,size));
+                VoronoiDiagram voronoi(mesh);
+                voronoi.fillAreas(servers);
+                links=voronoi.createLinks(servers);
+            }
+
+            RoutingTable dijkstra,floyd;
+            QElapsedTimer timer;
+            timer.start();
+            dijkstra.build(servers,true);
+            qint64 dijkstraTime=timer.nsecsElapsed();
+            timer.restart();
+            floyd.buildFloydWarshall(servers);
+            qint64 floydTime=timer.nsecsElapsed();
+
+            QVector<int> allTargets(n);
+            std::iota(allTargets.begin(),allTargets.end(),0);
+            int nDiff=countDifferences(servers,floyd,dijkstra,allTargets);
+            qInfo().noquote() << n << "servers," << links.size() << "links: Dijkstra" << QString::number(dijkstraTime/1e6,'f',1)
+                              << "ms, Floyd-Warshall" << QString::number(floydTime/1e6,'f',1) << "ms, differences" << nDiff;
+            if (crossover<0 && dijkstraTime<floydTime) crossover=n;
+            qDeleteAll(links);
+        }
+        if (crossover<0) qInfo().noquote() << graph+": Floyd-Warshall is faster up to 1600 servers";
+        else qInfo().noquote() << graph+": Dijkstra is faster from" << crossover << "servers";
+    }
+}
+
+void benchmarkDrones() {
+    qInfo() << "--- Drones ---";
+    const int n=100,nSteps=100;
+    const int size=1000;
+    QList<Server> servers=randomServers(n,size,n);
+    TriangleMesh mesh(servers);
+    mesh.setBox(QPoint(0,0),QSize(size,size));
+    VoronoiDiagram voronoi(mesh);
+    voronoi.fillAreas(servers);
+    QList<Link*> links=voronoi.createLinks(servers);
+    RoutingTable table;
+    table.build(servers,true);
+
+    for (int nDrones:{200000,1000000}) {
+        // the same drones are stepped by one thread, then by the threads of the pool
+        DroneSystem serial,parallel;
+        parallel.setParallel(true);
+        QRandomGenerator generator(nDrones);
+        for (int i=0; i<nDrones; i++) {
+            Vector2D position(generator.bounded(size),generator.bounded(size));
+            Server *target=&servers[generator.bounded(n)];
+            serial.add(QString("D%1").arg(i),position,target);
+            parallel.add(QString("D%1").arg(i),position,target);
+        }
+        serial.attach(servers,&table);
+        parallel.attach(servers,&table);
+        qint64 times[2];
+        DroneSystem *systems[2]={&serial,&parallel};
+        for (int k=0; k<2; k++) {
+            QElapsedTimer timer;
+            timer.start();
+            for (int step=0; step<nSteps; step++) {
+                systems[k]->step(0.1);
+            }
+            times[k]=timer.nsecsElapsed();
+        }
+        int nArrived=0,nDiff=0;
+        for (int i=0; i<nDrones; i++) {
+            if (serial.getState(i)==DroneSystem::State::Arrived) nArrived++;
+            if (serial.getPosition(i).x!=parallel.getPosition(i).x || serial.getPosition(i).y!=parallel.getPosition(i).y
+                || serial.getState(i)!=parallel.getState(i)) nDiff++;
+        }
+        qInfo().noquote() << nDrones << "drones," << n << "servers:" << QString::number(times[0]/1e6/nSteps,'f',1)
+                          << "ms per step, parallel" << QString::number(times[1]/1e6/nSteps,'f',1) << "ms,"
+                          << nArrived << "arrived after" << nSteps << "steps, differences" << nDiff;
+    }
+    qDeleteAll(links);
+}
+
+void benchmarkDroneEvents() {
+    qInfo() << "--- Drones: steps vs events ---";
+    const int n=100,nDrones=100000,size=1000;
+    const qreal dt=0.1;
+    QList<Server> servers=randomServers(n,size,n);
+    TriangleMesh mesh(servers);
+    mesh.setBox(QPoint(0,0),QSize(size,size));
+    VoronoiDiagram voronoi(mesh);
+    voronoi.fillAreas(servers);
+    QList<Link*> links=voronoi.createLinks(servers);
+    RoutingTable table;
+    table.build(servers,true);
+
+    DroneSystem stepped,events;
+    events.setEventDriven(true);
+    QRandomGenerator generator(nDrones);
+    for (int i=0; i<nDrones; i++) {
+        Vector2D position(generator.bounded(size),generator.bounded(size));
+        Server *target=&servers[generator.bounded(n)];
+        stepped.add(QString("D%1").arg(i),position,target);
+        events.add(QString("D%1").arg(i),position,target);
+    }
+    stepped.attach(servers,&table);
+    events.attach(servers,&table);
+    // periods of 5 minutes: the fleet is cruising, then most of the drones have arrived
+    const int nSteps=3000;
+    for (int period=0; period<4; period++) {
+        qint64 times[2];
+        DroneSystem *systems[2]={&stepped,&events};
+        for (int k=0; k<2; k++) {
+            QElapsedTimer timer;
+            timer.start();
+            for (int step=0; step<nSteps; step++) {
+                systems[k]->step(dt);
+            }
+            times[k]=timer.nsecsElapsed();
+        }
+        int arrived[2]={0,0};
+        qreal meanDistance=0;
+        for (int i=0; i<nDrones; i++) {
+            for (int k=0; k<2; k++) {
+                if (systems[k]->getState(i)==DroneSystem::State::Arrived) arrived[k]++;
+            }
+            meanDistance+=(stepped.getPosition(i)-events.getPosition(i)).length();
+        }
+        qInfo().noquote() << "t =" << int((period+1)*nSteps*dt) << "s:" << nDrones << "drones, steps"
+                          << QString::number(times[0]/1e6/nSteps,'f',3) << "ms per step, events"
+                          << QString::number(times[1]/1e6/nSteps,'f',3) << "ms, arrived" << arrived[0] << "/" << arrived[1]
+                          << ", mean distance between the two positions" << QString::number(meanDistance/nDrones,'f',3);
+    }
+    qDeleteAll(links);
+}
+
+void runBenchmarks() {
+    benchmarkVoronoi();
+    benchmarkRoutingUpdates();
+    benchmarkCongestion();
+    benchmarkFloydWarshall();
+    benchmarkShortestPaths();
+    benchmarkContractionHierarchy();
+    benchmarkLandmarks();
+    benchmarkDrones();
+    benchmarkDroneEvents();
+}
@@ -0,0 +1,87 @@
+/**
+ * @brief Benchmarks of the geometric and routing algorithms,
+ * run with the "--benchmark" argument of the application.
+ **/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <serveranddrone.h>
+
+/**
+ * @brief randomServers: servers at random positions in a square window
+ * @param n number of servers
+ * @param size side of the window
+ * @param seed seed of the generator, the same seed gives the same servers
+ */
+QList<Server> randomServers(int n,int size,quint32 seed);
+
+/**
+ * @brief benchmarkVoronoi: times the construction of the Voronoï areas by
+ * VoronoiDiagram and by the scan of the mesh for 1k, 10k and 100k servers.
+ */
+void benchmarkVoronoi();
+
+/**
+ * @brief benchmarkRoutingUpdates: times the repair of the routing table after
+ * changes of link costs, links and servers going down and up, compared to a
+ * full rebuild, for the AllPairs and TargetTrees modes.
+ */
+void benchmarkRoutingUpdates();
+
+/**
+ * @brief benchmarkShortestPaths: times the shortest path trees of 100k servers
+ * with the binary heap and with the radix heap.
+ */
+void benchmarkShortestPaths();
+
+/**
+ * @brief benchmarkContractionHierarchy: times the preprocessing and the queries
+ * of the contraction hierarchy for 10k and 100k servers, compared to a Dijkstra
+ * shortest path tree.
+ */
+void benchmarkContractionHierarchy();
+
+/**
+ * @brief benchmarkLandmarks: times the preprocessing and the A* queries of the
+ * landmark router for 200k servers and 4 or 16 landmarks, compared to a Dijkstra
+ * shortest path tree.
+ */
+void benchmarkLandmarks();
+
+/**
+ * @brief benchmarkCongestion: times the periodic updates of the link costs
+ * from the traffic of drones that all fly toward a few targets, with the repair
+ * spread over ticks of 10 ms, compared to a full rebuild of the routing table.
+ */
+void benchmarkCongestion();
+
+/**
+ * @brief benchmarkFloydWarshall: times the all-pairs table built by Dijkstra
+ * and by the blocked Floyd-Warshall for growing maps, then prints the number
+ * of servers from which Dijkstra is faster (crossover point). The sparse graph
+ * of the Voronoi links is compared to dense graphs, where each server is linked
+ * to its n/16 and n/4 nearest servers.
+ */
+void benchmarkFloydWarshall();
+
+/**
+ * @brief benchmarkDrones: times the steps of 200k and 1M drones flying toward
+ * random targets on a map of 100 servers, on one core and with the threads of
+ * the pool, then checks that both modes give the same positions.
+ */
+void benchmarkDrones();
+
+/**
+ * @brief benchmarkDroneEvents: times the steps of 100k drones by the kinematics
+ * kernel and by the event-driven mode, over 20 minutes of simulated time,
+ * and compares their positions.
+ */
+void benchmarkDroneEvents();
+
+/**
+ * @brief runBenchmarks: runs all the benchmarks and prints the times
+ */
+void runBenchmarks();
+
+#endif // BENCHMARK_H
@@ -65,17 +65,19 @@ void Canvas::paintEvent(QPaintEvent *) {
 
     // drawing the drones
     painter.setPen(Qt::white);
-    for (auto &d:drones) {
+    for (int i=0; i<drones.size(); i++) {
         painter.save();
         // place and orient the drone
-        painter.translate(d.position.x,d.position.y);
-        painter.rotate(d.azimut);
+        Vector2D position=drones.getPosition(i);
+        painter.translate(position.x,position.y);
+        painter.rotate(drones.getAzimuth(i));
         painter.drawImage(rect,droneImg);
 
-        int tw=fm.horizontalAdvance(d.name)+2;
+        const QString &name=drones.getName(i);
+        int tw=fm.horizontalAdvance(name)+2;
         int th=fm.height()+2;
         r.setRect(-tw/2,-15,tw,th);
-        painter.drawText(r,d.name);
+        painter.drawText(r,name);
 
         painter.restore();
     }
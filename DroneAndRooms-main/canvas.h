@@ -5,6 +5,7 @@
 #include <QMouseEvent>
 #include <QPaintEvent>
 #include <serveranddrone.h>
+#include <dronesystem.h>
 
 class Canvas : public QWidget {
     Q_OBJECT
@@ -34,7 +35,7 @@ public:
     void mousePressEvent(QMouseEvent *event) override;
 
     QList<Server> servers;
-    QList<Drone> drones;
+    DroneSystem drones;
     QList<Link*> links;
     bool showGraph=false;
 signals:
@@ -0,0 +1,31 @@
+#include "congestion.h"
+#include <algorithm>
+#include <cmath>
+
+qreal CongestionControl::cost(qreal length,qreal flow) const {
+    return length*(1.0+alpha*std::pow(flow/capacity,beta));
+}
+
+int CongestionControl::update(const QList<Server> &servers,const QList<Link*> &links,RoutingTable &table,qreal period) {
+    if (period<=0) return 0;
+    // relative change of cost of each link, the largest ones are applied
+    QVector<QPair<qreal,QPair<Link*,qreal>>> candidates;
+    for (Link *l:links) {
+        int n=l->takeCrossings();
+        qreal &flow=flows[l];
+        flow=(1.0-smoothing)*flow+smoothing*n/period;
+        qreal newCost=cost(l->getLength(),flow);
+        qreal change=std::abs(newCost-l->getDistance())/l->getDistance();
+        if (change>threshold) candidates.push_back({change,{l,newCost}});
+    }
+    if (candidates.isEmpty()) return 0;
+    if (candidates.size()>maxLinksPerUpdate) {
+        std::nth_element(candidates.begin(),candidates.begin()+maxLinksPerUpdate,candidates.end(),
+                         [](const auto &a,const auto &b) { return a.first>b.first; });
+        candidates.resize(maxLinksPerUpdate);
+    }
+    QVector<QPair<Link*,qreal>> distances;
+    for (auto &candidate:candidates) distances.push_back(candidate.second);
+    table.startLinkDistances(servers,distances);
+    return distances.size();
+}
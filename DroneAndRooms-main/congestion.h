@@ -0,0 +1,61 @@
+/**
+ * @brief Cost of the links from the traffic of the drones, the routes avoid
+ * the congested doors.
+ **/
+
+#ifndef CONGESTION_H
+#define CONGESTION_H
+
+#include <routing.h>
+
+/**
+ * @brief The CongestionControl class: periodic update of the link costs.
+ *
+ * The drones count their door crossings on the links. At each update, the
+ * flow of each link (drones per second) is smoothed over the last periods and
+ * its cost follows the BPR function of road traffic:
+ *     cost = length * (1 + alpha * (flow/capacity)^beta)
+ * so that the cost stays the length while the flow is low and grows quickly
+ * near the capacity. Only the links whose cost has changed by more than the
+ * threshold are given to the routing table, at most maxLinksPerUpdate of them
+ * (the largest changes first), and the table is repaired once for all of them:
+ * an update costs a few incremental repairs, not a rebuild. The repair is only
+ * started: the caller spreads it over the next ticks with RoutingTable::continueRepair.
+ */
+class CongestionControl {
+public:
+    qreal capacity=1.0; ///< flow of a door (drones per second) where the cost is (1+alpha) times the length
+    qreal alpha=0.15;
+    qreal beta=4;
+    qreal smoothing=0.5; ///< weight of the last period in the smoothed flow
+    qreal threshold=0.1; ///< relative change of cost that updates a link
+    int maxLinksPerUpdate=16;
+
+    /**
+     * @brief cost: BPR cost of a link
+     * @param length length of the link
+     * @param flow smoothed flow of the link (drones per second)
+     */
+    qreal cost(qreal length,qreal flow) const;
+    /**
+     * @brief update: read the crossings of the links since the last update,
+     * change the costs of the congested or released links and start the repair of the table
+     * @param links all the links, their crossing counters are reset
+     * @param period time since the last update in seconds
+     * @return the number of links whose cost has changed
+     */
+    int update(const QList<Server> &servers,const QList<Link*> &links,RoutingTable &table,qreal period);
+    /**
+     * @brief reset: forget the flows, to be called when the links change
+     */
+    void reset() { flows.clear(); }
+    /**
+     * @brief getFlow
+     * @return the smoothed flow of a link, 0 if it has never been crossed
+     */
+    qreal getFlow(const Link *link) const { return flows.value(link,0); }
+private:
+    QHash<const Link*,qreal> flows;
+};
+
+#endif // CONGESTION_H
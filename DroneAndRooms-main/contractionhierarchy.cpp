@@ -0,0 +1,375 @@
+#include "contractionhierarchy.h"
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <cstdlib>
+
+namespace {
+const qreal INF = std::numeric_limits<qreal>::infinity();
+const int witnessSettleLimit = 200; ///< larger witness searches give up and add the shortcut
+
+// Priority queue item
+struct Item {
+    qreal d;
+    int v;
+    bool operator>(const Item& o) const { return d > o.d; }
+};
+
+/**
+ * @brief The SearchSpace struct: distances of a Dijkstra search, a server is
+ * reached if its stamp is the current generation, so that the array is not
+ * cleared between two searches
+ */
+struct SearchSpace {
+    struct Entry {
+        qreal dist;
+        int parent; // edge used to reach the server
+        quint32 stamp;
+    };
+    QVector<Entry> entries;
+    QVector<quint32> goal; // servers whose distance is wanted, by the witness searches
+    quint32 generation=0;
+    std::vector<Item> heap;
+
+    void start(int n) {
+        if (entries.size()!=n) {
+            entries.fill({INF,-1,0},n);
+            goal.fill(0,n);
+            generation=0;
+        }
+        if (++generation==0) {
+            for (auto &e:entries) e.stamp=0;
+            goal.fill(0);
+            generation=1;
+        }
+        heap.clear();
+    }
+    bool reached(int v) const { return entries[v].stamp==generation; }
+    qreal distance(int v) const { return reached(v) ? entries[v].dist : INF; }
+    void set(int v,qreal d,int edge) {
+        entries[v]={d,edge,generation};
+        heap.push_back({d,v});
+        std::push_heap(heap.begin(),heap.end(),std::greater<Item>());
+    }
+    Item pop() {
+        std::pop_heap(heap.begin(),heap.end(),std::greater<Item>());
+        Item top=heap.back();
+        heap.pop_back();
+        return top;
+    }
+};
+
+// forward and backward searches of the queries, one pair for each thread
+thread_local SearchSpace querySpaces[2];
+
+/**
+ * @brief The Contraction class: graph of the servers that are not contracted yet
+ */
+class Contraction {
+public:
+    /**
+     * @brief The Arc struct: edge seen from one of its servers
+     */
+    struct Arc {
+        int to;
+        qreal length;
+        int edge;
+    };
+
+    Contraction(int n,QVector<int> &p_a,QVector<int> &p_b,QVector<qreal> &p_length,
+                QVector<int> &p_child1,QVector<int> &p_child2,QVector<Link*> &p_links):
+        a(p_a),b(p_b),length(p_length),child1(p_child1),child2(p_child2),links(p_links),
+        adjacency(n),deletedNeighbours(n,0) {}
+
+    /**
+     * @brief setEdge: add an edge between u and w, or shorten the existing one
+     */
+    void setEdge(int u,int w,qreal l,int c1,int c2,Link *link) {
+        for (Arc &arc:adjacency[u]) {
+            if (arc.to==w) {
+                if (arc.length<=l) return;
+                // the edges of the contracted servers never change, so the
+                // shortcuts that use this edge stay valid
+                int e=arc.edge;
+                length[e]=l;
+                child1[e]=c1;
+                child2[e]=c2;
+                links[e]=link;
+                arc.length=l;
+                for (Arc &back:adjacency[w]) {
+                    if (back.edge==e) back.length=l;
+                }
+                return;
+            }
+        }
+        int e=a.size();
+        a.push_back(u);
+        b.push_back(w);
+        length.push_back(l);
+        child1.push_back(c1);
+        child2.push_back(c2);
+        links.push_back(link);
+        adjacency[u].push_back({w,l,e});
+        adjacency[w].push_back({u,l,e});
+    }
+
+    /**
+     * @brief witness: Dijkstra from list[i] in the graph without server excluded,
+     * stopped when the next neighbours list[i+1..] are settled, after maxDistance
+     * or after witnessSettleLimit servers
+     */
+    void witness(const QVector<Arc> &list,int i,int excluded,qreal maxDistance,SearchSpace &ws) const {
+        ws.start(adjacency.size());
+        int nGoals=0;
+        for (int j=i+1; j<list.size(); j++) {
+            ws.goal[list[j].to]=ws.generation;
+            nGoals++;
+        }
+        ws.set(list[i].to,0,-1);
+        int nSettled=0;
+        while (!ws.heap.empty()) {
+            Item cur=ws.pop();
+            if (cur.d!=ws.entries[cur.v].dist) continue;
+            if (cur.d>maxDistance || ++nSettled>witnessSettleLimit) break;
+            if (ws.goal[cur.v]==ws.generation && --nGoals==0) break;
+            for (const Arc &arc:adjacency[cur.v]) {
+                if (arc.to==excluded) continue;
+                qreal nd=cur.d+arc.length;
+                if (nd<ws.distance(arc.to)) ws.set(arc.to,nd,arc.edge);
+            }
+        }
+    }
+
+    /**
+     * @brief contract: find the shortcuts needed to remove server v
+     * @param apply add the shortcuts and remove v from the graph, otherwise only count them
+     * @return the priority of v: edge difference plus contracted neighbours
+     */
+    int contract(int v,bool apply,SearchSpace &ws,QVector<Arc> &list) {
+        list=adjacency[v];
+        int nAdded=0;
+        for (int i=0; i+1<list.size(); i++) {
+            qreal maxDistance=0;
+            for (int j=i+1; j<list.size(); j++) maxDistance=std::max(maxDistance,list[i].length+list[j].length);
+            witness(list,i,v,maxDistance,ws);
+            for (int j=i+1; j<list.size(); j++) {
+                qreal via=list[i].length+list[j].length;
+                if (ws.distance(list[j].to)>via) {
+                    nAdded++;
+                    if (apply) setEdge(list[i].to,list[j].to,via,list[i].edge,list[j].edge,nullptr);
+                }
+            }
+        }
+        if (apply) {
+            // the arcs toward v are not needed anymore by the neighbours
+            for (auto &n:list) {
+                deletedNeighbours[n.to]++;
+                QVector<Arc> &arcs=adjacency[n.to];
+                for (int k=0; k<arcs.size(); k++) {
+                    if (arcs[k].edge==n.edge) {
+                        arcs[k]=arcs.last();
+                        arcs.removeLast();
+                        break;
+                    }
+                }
+            }
+            adjacency[v].clear();
+            adjacency[v].squeeze();
+        }
+        return 2*(nAdded-int(list.size()))+deletedNeighbours[v];
+    }
+
+private:
+    QVector<int> &a,&b;
+    QVector<qreal> &length;
+    QVector<int> &child1,&child2;
+    QVector<Link*> &links;
+    QVector<QVector<Arc>> adjacency; // edges of each server toward the servers that are not contracted
+    QVector<int> deletedNeighbours;
+};
+}
+
+void ContractionHierarchy::build(const QList<Server> &servers) {
+    version++;
+    nServers=servers.size();
+    edges.clear();
+
+    // the edges are stored as arrays during the contraction
+    QVector<int> a,b,child1,child2;
+    QVector<qreal> length;
+    QVector<Link*> links;
+    Contraction graph(nServers,a,b,length,child1,child2,links);
+    for (auto &s:servers) {
+        for (Link *l:s.links) {
+            int u=l->getNode1()->id,w=l->getNode2()->id;
+            // each link once, the shortest one between two servers
+            if (l->isUsable() && u==s.id && u!=w) graph.setEdge(u,w,l->getDistance(),-1,-1,l);
+        }
+    }
+
+    // order of contraction, the priorities are updated when a server is popped
+    SearchSpace ws;
+    QVector<Contraction::Arc> list;
+    std::priority_queue<std::pair<int,int>,std::vector<std::pair<int,int>>,std::greater<std::pair<int,int>>> queue;
+    for (int v=0; v<nServers; v++) queue.push({graph.contract(v,false,ws,list),v});
+    rank.fill(-1,nServers);
+    serverOfRank.resize(nServers);
+    int nContracted=0;
+    while (!queue.empty()) {
+        auto top=queue.top();
+        queue.pop();
+        int v=top.second;
+        if (rank[v]>=0) continue;
+        int priority=graph.contract(v,false,ws,list);
+        if (!queue.empty() && priority>queue.top().first) {
+            queue.push({priority,v});
+            continue;
+        }
+        graph.contract(v,true,ws,list);
+        serverOfRank[nContracted]=v;
+        rank[v]=nContracted++;
+    }
+
+    edges.resize(a.size());
+    for (int e=0; e<a.size(); e++) edges[e]={a[e],b[e],length[e],child1[e],child2[e],links[e]};
+    nShortcuts=std::count(links.begin(),links.end(),nullptr);
+
+    // each edge goes up from its less important server, CSR layout indexed by
+    // rank so that the important servers, visited by most queries, are close in memory
+    upFirst.fill(0,nServers+1);
+    for (auto &e:edges) upFirst[std::min(rank[e.a],rank[e.b])+1]++;
+    for (int r=0; r<nServers; r++) upFirst[r+1]+=upFirst[r];
+    upEdges.resize(edges.size());
+    QVector<int> next=upFirst;
+    for (int e=0; e<edges.size(); e++) {
+        int low=rank[edges[e].a],high=rank[edges[e].b];
+        if (low>high) std::swap(low,high);
+        upEdges[next[low]++]={high,edges[e].length,e};
+    }
+}
+
+Link* ContractionHierarchy::unpack(int edge,int from) const {
+    // the first half of a shortcut that contains server from leaves from
+    while (!edges[edge].link) {
+        const Edge &first=edges[edges[edge].child1];
+        edge=(first.a==from || first.b==from) ? edges[edge].child1 : edges[edge].child2;
+    }
+    return edges[edge].link;
+}
+
+void ContractionHierarchy::unpack(int edge,int from,QVector<Link*> &route) const {
+    const Edge &e=edges[edge];
+    if (e.link) {
+        route.push_back(e.link);
+        return;
+    }
+    int first=(edges[e.child1].a==from || edges[e.child1].b==from) ? e.child1 : e.child2;
+    int second=(first==e.child1) ? e.child2 : e.child1;
+    unpack(first,from,route);
+    unpack(second,otherServer(first,from),route);
+}
+
+int ContractionHierarchy::search(int from,int to,qreal &length) const {
+    // forward search from server from, backward search from server to, in rank numbering
+    SearchSpace *search=querySpaces;
+    search[0].start(nServers);
+    search[1].start(nServers);
+    search[0].set(rank[from],0,-1);
+    search[1].set(rank[to],0,-1);
+    length=INF;
+    int meeting=-1;
+    while (true) {
+        // the side with the smallest distance, stopped when it cannot improve the best path
+        qreal top[2];
+        for (int side=0; side<2; side++) top[side]=search[side].heap.empty() ? INF : search[side].heap.front().d;
+        int side=(top[0]<=top[1] ? 0 : 1);
+        if (top[side]>=length) break;
+        SearchSpace &ws=search[side];
+        const SearchSpace &opposite=search[1-side];
+        Item cur=ws.pop();
+        if (cur.d!=ws.entries[cur.v].dist) continue;
+        if (opposite.reached(cur.v) && cur.d+opposite.entries[cur.v].dist<length) {
+            length=cur.d+opposite.entries[cur.v].dist;
+            meeting=cur.v;
+        }
+        // stall on demand: cur.v is reached shorter from a more important server
+        bool stalled=false;
+        for (int i=upFirst[cur.v]; i<upFirst[cur.v+1] && !stalled; i++) {
+            stalled=(ws.distance(upEdges[i].to)+upEdges[i].length<cur.d);
+        }
+        if (stalled) continue;
+        for (int i=upFirst[cur.v]; i<upFirst[cur.v+1]; i++) {
+            const UpEdge &up=upEdges[i];
+            qreal nd=cur.d+up.length;
+            if (nd<ws.distance(up.to)) ws.set(up.to,nd,up.edge);
+        }
+    }
+    return meeting;
+}
+
+int ContractionHierarchy::otherServer(int edge,int v) const {
+    return edges[edge].a==v ? edges[edge].b : edges[edge].a;
+}
+
+qreal ContractionHierarchy::query(int from,int to,Link **firstLink) const {
+    if (firstLink) *firstLink=nullptr;
+    if (from==to) return 0;
+    qreal length;
+    int meeting=search(from,to,length);
+    if (meeting<0) return -1;
+
+    if (firstLink) {
+        // first edge of the path: up from server from, or down from it if it is the meeting server
+        int edge;
+        if (meeting==rank[from]) {
+            edge=querySpaces[1].entries[meeting].parent;
+        } else {
+            int v=meeting;
+            while (true) {
+                edge=querySpaces[0].entries[v].parent;
+                int u=otherServer(edge,serverOfRank[v]);
+                if (u==from) break;
+                v=rank[u];
+            }
+        }
+        *firstLink=unpack(edge,from);
+    }
+    return length;
+}
+
+QVector<Link*> ContractionHierarchy::getRoute(const Server &from,int to) const {
+    QVector<Link*> route;
+    qreal length;
+    if (from.id==to) return route;
+    int meeting=search(from.id,to,length);
+    if (meeting<0) return route;
+    // up edges from server from to the meeting server, found backward
+    QVector<int> upPath;
+    for (int r=meeting; r!=rank[from.id];) {
+        int edge=querySpaces[0].entries[r].parent;
+        upPath.push_back(edge);
+        r=rank[otherServer(edge,serverOfRank[r])];
+    }
+    int v=from.id;
+    for (int i=upPath.size()-1; i>=0; i--) {
+        unpack(upPath[i],v,route);
+        v=otherServer(upPath[i],v);
+    }
+    // down edges from the meeting server to server #to
+    while (v!=to) {
+        int edge=querySpaces[1].entries[rank[v]].parent;
+        unpack(edge,v,route);
+        v=otherServer(edge,v);
+    }
+    return route;
+}
+
+Link* ContractionHierarchy::getNextLink(const Server &from,int to) const {
+    Link *link;
+    query(from.id,to,&link);
+    return link;
+}
+
+float ContractionHierarchy::getDistance(const QList<Server> &,int from,int to) const {
+    return float(query(from,to));
+}
@@ -0,0 +1,92 @@
+/**
+ * @brief Contraction hierarchy of the links between the servers, for the
+ * shortest path queries on very large maps.
+ **/
+
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <routing.h>
+
+/**
+ * @brief The ContractionHierarchy class: routing engine without table.
+ *
+ * The servers are contracted one by one, the least important first (few
+ * shortcuts created, few contracted neighbours). Contracting a server adds a
+ * shortcut between two of its neighbours when it is on their only shortest
+ * path (witness search). A query is a bidirectional Dijkstra that only follows
+ * the edges toward more important servers, it visits a few hundreds of servers
+ * on maps of 100k servers. The first link of the path is found by unpacking the
+ * first shortcut.
+ * The memory is O(links), the hierarchy must be rebuilt when the links change.
+ */
+class ContractionHierarchy : public Router {
+public:
+    /**
+     * @brief build: contraction of all the servers, only the usable links are kept
+     * @param servers the servers (the id of a server is its index) and their links
+     */
+    void build(const QList<Server> &servers);
+    int size() const { return nServers; }
+    /**
+     * @brief getNbShortcuts
+     * @return number of edges added by the contraction
+     */
+    int getNbShortcuts() const { return nShortcuts; }
+    /**
+     * @brief query: shortest path from server #from to server #to
+     * @param firstLink if not nullptr, set to the first link of the path (nullptr if none)
+     * @return the length of the path, -1 if server #to is unreachable
+     */
+    qreal query(int from,int to,Link **firstLink=nullptr) const;
+    Link* getNextLink(const Server &from,int to) const override;
+    /**
+     * @brief getRoute: one query, then all the shortcuts of the path are unpacked
+     */
+    QVector<Link*> getRoute(const Server &from,int to) const override;
+    float getDistance(const QList<Server> &servers,int from,int to) const override;
+private:
+    /**
+     * @brief The Edge struct: link or shortcut between two servers
+     */
+    struct Edge {
+        int a,b;
+        qreal length;
+        int child1,child2; ///< edges (a,c) and (c,b) replaced by a shortcut, -1 for a link
+        Link *link; ///< nullptr for a shortcut
+    };
+    /**
+     * @brief The UpEdge struct: edge toward a more important server
+     */
+    struct UpEdge {
+        int to; ///< rank of the server
+        qreal length;
+        int edge;
+    };
+    /**
+     * @brief unpack
+     * @return the link of the edge #edge that leaves server #from
+     */
+    Link* unpack(int edge,int from) const;
+    /**
+     * @brief unpack: append the links of the edge #edge, from server #from, to the route
+     */
+    void unpack(int edge,int from,QVector<Link*> &route) const;
+    /**
+     * @brief search: bidirectional upward search, the parents are left in the search spaces of the thread
+     * @param length set to the length of the shortest path
+     * @return the rank of the server where the two searches meet, -1 if server #to is unreachable
+     */
+    int search(int from,int to,qreal &length) const;
+    int otherServer(int edge,int v) const;
+
+    int nServers=0;
+    int nShortcuts=0;
+    QVector<Edge> edges;
+    QVector<int> rank; ///< order of contraction of each server
+    QVector<int> serverOfRank;
+    QVector<int> upFirst; ///< up edges of the server of rank r: upEdges[upFirst[r]..upFirst[r+1]-1]
+    QVector<UpEdge> upEdges;
+};
+
+#endif // CONTRACTIONHIERARCHY_H
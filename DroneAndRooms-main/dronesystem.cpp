@@ -0,0 +1,324 @@
+#include "dronesystem.h"
+#include <QtConcurrent>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+// Check if two positions are considered close enough
+bool nearPos(const Vector2D &a,const Vector2D &b) {
+    return (a-b).length()<=minDistance;
+}
+
+Vector2D serverPosition(const Server *s) {
+    return Vector2D(s->position.x(),s->position.y());
+}
+
+/**
+ * @brief The SegmentProfile struct: distance to the destination of a drone that
+ * leaves at rest, integrated in closed form.
+ *
+ * Far from the destination the drone accelerates up to speedMax, then in the
+ * slow down zone its speed is min(f.d²,speedMax) with f=speedLocal/slowDownDistance:
+ * at constant speed until d=dc, then d(t)=dc/(1+f.dc.t), reaching minDistance
+ * at t=(1/minDistance-1/dc)/f.
+ */
+struct SegmentProfile {
+    qreal t1,t2,t3; ///< duration of the phases: outside the slow down zone, at speedMax in the zone, slowing down
+    qreal d2,d3; ///< distances at the beginning of the phases 2 and 3
+
+    const qreal f=speedLocal/slowDownDistance;
+    const qreal tMax=speedMax/accelation; ///< time to reach speedMax from rest
+    const qreal sMax=speedMax*speedMax/(2*accelation); ///< distance to reach speedMax from rest
+
+    explicit SegmentProfile(qreal length) {
+        qreal dc=std::min(slowDownDistance,std::sqrt(speedMax/f));
+        qreal l1=std::max(0.0,length-slowDownDistance);
+        t1=(l1<=sMax) ? std::sqrt(2*l1/accelation) : tMax+(l1-sMax)/speedMax;
+        d2=std::min(length,slowDownDistance);
+        t2=std::max(0.0,d2-dc)/speedMax;
+        d3=std::min(d2,dc);
+        t3=(d3>minDistance) ? (1/minDistance-1/d3)/f : 0;
+    }
+    qreal duration() const { return t1+t2+t3; }
+    /**
+     * @brief distance
+     * @return the distance to the destination t seconds after the departure
+     */
+    qreal distance(qreal length,qreal t) const {
+        if (t<t1) return length-((t<=tMax) ? 0.5*accelation*t*t : sMax+(t-tMax)*speedMax);
+        t-=t1;
+        if (t<t2) return d2-t*speedMax;
+        t-=t2;
+        return std::max(std::min(d3,minDistance),d3/(1+f*d3*t));
+    }
+};
+
+struct Kinematics {
+    float dt,acc,vMax,slowDown,slowDownFactor,minDistance2;
+};
+
+// kinematics of one block of drones, branchless: both speeds are computed,
+// the drones that do not move keep a null speed
+void move(const Kinematics &k,float *__restrict px,float *__restrict py,float *__restrict vx,float *__restrict vy,
+          const float *__restrict dx,const float *__restrict dy,const quint8 *__restrict st,quint8 *__restrict arrived) {
+    const quint8 movingState=quint8(DroneSystem::State::Moving);
+    for (int j=0; j<DroneSystem::blockSize; j++) {
+        bool moving=st[j]==movingState;
+        // Compute direction and distance to destination
+        float dirX=dx[j]-px[j],dirY=dy[j]-py[j];
+        float d=std::sqrt(dirX*dirX+dirY*dirY);
+        // Slow down when approaching the destination, otherwise accelerate toward it
+        float slowX=k.slowDownFactor*d*dirX,slowY=k.slowDownFactor*d*dirY;
+        float a=k.acc/std::max(d,1e-6f);
+        float accX=vx[j]+a*dirX,accY=vy[j]+a*dirY;
+        float sx=d<k.slowDown ? slowX : accX;
+        float sy=d<k.slowDown ? slowY : accY;
+        float s=std::sqrt(sx*sx+sy*sy);
+        float clamp=k.vMax/std::max(s,k.vMax);
+        sx=moving ? sx*clamp : vx[j];
+        sy=moving ? sy*clamp : vy[j];
+        vx[j]=sx;
+        vy[j]=sy;
+        // Update position
+        float nx=px[j]+k.dt*sx,ny=py[j]+k.dt*sy;
+        px[j]=nx;
+        py[j]=ny;
+        float ex=dx[j]-nx,ey=dy[j]-ny;
+        arrived[j]=quint8(moving & (ex*ex+ey*ey<=k.minDistance2));
+    }
+}
+}
+
+int DroneSystem::add(const QString &name,const Vector2D &position,Server *target) {
+    int i=nDrones++;
+    int padded=(nDrones+blockSize-1)/blockSize*blockSize;
+    if (posX.size()<padded) {
+        // the padding drones are idle at the origin
+        for (auto *field:{&posX,&posY,&speedX,&speedY,&destX,&destY,&headingX,&headingY,&segmentLength}) field->resize(padded,0.0f);
+        segmentStart.resize(padded,0.0);
+        state.resize(padded,quint8(State::Idle));
+        due.resize(padded,0);
+    }
+    posX[i]=destX[i]=position.x;
+    posY[i]=destY[i]=position.y;
+    speedX[i]=speedY[i]=0;
+    headingX[i]=0;
+    headingY[i]=-1; // north, azimuth 0
+    state[i]=quint8(State::Idle);
+    due[i]=0;
+    Cold drone;
+    drone.name=name;
+    drone.target=target;
+    cold.push_back(drone);
+    return i;
+}
+
+void DroneSystem::clear() {
+    nDrones=0;
+    for (auto *field:{&posX,&posY,&speedX,&speedY,&destX,&destY,&headingX,&headingY,&segmentLength}) field->clear();
+    segmentStart.clear();
+    events.clear();
+    now=0;
+    state.clear();
+    due.clear();
+    cold.clear();
+}
+
+void DroneSystem::attach(QList<Server> &servers,const Router *router) {
+    routing=router;
+    for (int i=0; i<nDrones; i++) {
+        Cold &drone=cold[i];
+        // server of the area overflown by the drone
+        Vector2D position=getPosition(i);
+        posX[i]=position.x;
+        posY[i]=position.y;
+        segmentLength[i]=0;
+        auto it=servers.begin();
+        while (it!=servers.end() && !it->area.contains(position)) it++;
+        drone.connectedTo= it!=servers.end()?&(*it):nullptr;
+        drone.routeServer=nullptr;
+        drone.route.clear();
+        speedX[i]=speedY[i]=0;
+        if (drone.connectedTo && drone.target) {
+            destX[i]=drone.connectedTo->position.x();
+            destY[i]=drone.connectedTo->position.y();
+            state[i]=quint8(State::Moving);
+        } else {
+            destX[i]=posX[i];
+            destY[i]=posY[i];
+            state[i]=quint8(State::Idle);
+        }
+        due[i]=state[i]==quint8(State::Moving) && nearPos(position,getDestination(i));
+    }
+    now=0;
+    events.clear();
+    if (eventDriven) {
+        for (int i=0; i<nDrones; i++) {
+            if (state[i]==quint8(State::Moving)) schedule(i,now,false);
+        }
+    }
+}
+
+void DroneSystem::step(qreal dt) {
+    if (eventDriven) {
+        // only the drones whose arrival is due, each one at its own arrival time
+        now+=dt;
+        while (!events.empty() && events.front().time<=now) {
+            std::pop_heap(events.begin(),events.end(),std::greater<Event>());
+            Event e=events.back();
+            events.pop_back();
+            int i=e.drone;
+            arrive(i);
+            if (state[i]==quint8(State::Moving)) {
+                schedule(i,e.time,posX[i]==destX[i] && posY[i]==destY[i]);
+            }
+        }
+        return;
+    }
+    int nThreads=QThreadPool::globalInstance()->maxThreadCount();
+    if (!parallel || nDrones<parallelThreshold || nThreads<2) {
+        stepRange(0,nDrones,float(dt));
+        return;
+    }
+    // more chunks than threads: the events are not evenly spread over the array
+    int nChunks=4*nThreads;
+    int nBlocks=(nDrones+blockSize-1)/blockSize;
+    int chunkSize=(nBlocks+nChunks-1)/nChunks*blockSize;
+    QVector<int> chunks;
+    for (int first=0; first<nDrones; first+=chunkSize) chunks.push_back(first);
+    QtConcurrent::blockingMap(chunks,[=](int first) {
+        stepRange(first,qMin(first+chunkSize,nDrones),float(dt));
+    });
+}
+
+void DroneSystem::stepRange(int first,int last,float dt) {
+    // events: the few drones that have reached their destination
+    for (int i=first; i<last; i++) {
+        if (due[i]) arrive(i);
+    }
+    // kinematics of all the drones
+    for (int b=first; b<last; b+=blockSize) {
+        moveBlock(b,dt);
+    }
+}
+
+void DroneSystem::arrive(int i) {
+    Cold &drone=cold[i];
+    Vector2D position(destX[i],destY[i]);
+    posX[i]=position.x;
+    posY[i]=position.y;
+    // the drone stops: its orientation is kept
+    if (speedX[i]!=0 || speedY[i]!=0) {
+        headingX[i]=speedX[i];
+        headingY[i]=speedY[i];
+    }
+    speedX[i]=speedY[i]=0;
+    due[i]=0;
+
+    // Final stop when reaching the target server
+    Vector2D connectedPos=serverPosition(drone.connectedTo);
+    if (drone.connectedTo==drone.target && nearPos(position,serverPosition(drone.target))) {
+        state[i]=quint8(State::Arrived);
+        return;
+    }
+
+    Vector2D destination=connectedPos;
+    if (nearPos(position,connectedPos)) {
+        // Follow the shortest path to the target server
+        Link *next=nextLink(drone);
+        if (next) destination=next->getEdgeCenter();
+    } else {
+        // Check if the drone is crossing an edge center
+        for (Link *l:drone.connectedTo->links) {
+            if (nearPos(position,l->getEdgeCenter())) {
+                // Switch to the adjacent server area
+                l->addCrossing();
+                drone.connectedTo=(l->getNode1()==drone.connectedTo) ? l->getNode2() : l->getNode1();
+                destination=serverPosition(drone.connectedTo);
+                break;
+            }
+        }
+    }
+    destX[i]=destination.x;
+    destY[i]=destination.y;
+}
+
+void DroneSystem::schedule(int i,qreal t,bool waiting) {
+    segmentStart[i]=t;
+    float dirX=destX[i]-posX[i],dirY=destY[i]-posY[i];
+    float length=std::sqrt(dirX*dirX+dirY*dirY);
+    segmentLength[i]=length;
+    qreal arrival=t;
+    if (waiting) {
+        arrival+=retryPeriod;
+    } else if (length>minDistance) {
+        // the drone is drawn in the direction of its flight
+        headingX[i]=dirX/length;
+        headingY[i]=dirY/length;
+        arrival+=SegmentProfile(length).duration();
+    }
+    events.push_back({arrival,i});
+    std::push_heap(events.begin(),events.end(),std::greater<Event>());
+}
+
+Vector2D DroneSystem::getPosition(int i) const {
+    if (!eventDriven || state[i]!=quint8(State::Moving) || segmentLength[i]<=minDistance) {
+        return Vector2D(posX[i],posY[i]);
+    }
+    // evaluated on the segment from the time of departure
+    qreal length=segmentLength[i];
+    qreal d=SegmentProfile(length).distance(length,std::max(0.0,now-segmentStart[i]));
+    qreal k=d/length;
+    return Vector2D(destX[i]-k*(destX[i]-posX[i]),destY[i]-k*(destY[i]-posY[i]));
+}
+
+Link* DroneSystem::nextLink(Cold &drone) {
+    if (!routing) return nullptr;
+    if (drone.routeServer!=drone.connectedTo || drone.routeTarget!=drone.target->id || drone.routeVersion!=routing->getVersion()) {
+        drone.route=routing->getRoute(*drone.connectedTo,drone.target->id);
+        drone.routeStep=0;
+        drone.routeTarget=drone.target->id;
+        drone.routeVersion=routing->getVersion();
+    }
+    drone.routeServer=drone.connectedTo;
+    if (drone.routeStep>=drone.route.size()) return nullptr;
+    Link *next=drone.route[drone.routeStep];
+    if (!next->isUsable()) {
+        // the link or the next server is down: loop-free alternate until the router is repaired,
+        // or wait at the server if there is none
+        Link *backup=routing->getBackupLink(*drone.connectedTo,drone.target->id);
+        if (!backup || !backup->isUsable()) return nullptr;
+        drone.route.clear(); // asked again from the next server
+        drone.routeStep=0;
+        drone.routeServer=nullptr;
+        return backup;
+    }
+    drone.routeStep++;
+    drone.routeServer=(next->getNode1()==drone.connectedTo) ? next->getNode2() : next->getNode1();
+    return next;
+}
+
+void DroneSystem::moveBlock(int first,float dt) {
+    Kinematics k;
+    k.acc=float(accelation)*dt;
+    k.vMax=float(speedMax);
+    k.slowDown=float(slowDownDistance);
+    k.slowDownFactor=float(speedLocal/slowDownDistance);
+    k.minDistance2=float(minDistance*minDistance);
+    k.dt=dt;
+    move(k,posX.data()+first,posY.data()+first,speedX.data()+first,speedY.data()+first,
+         destX.constData()+first,destY.constData()+first,state.constData()+first,due.data()+first);
+}
+
+qreal DroneSystem::getAzimuth(int i) const {
+    bool stopped=speedX[i]==0 && speedY[i]==0;
+    qreal x=stopped ? headingX[i] : speedX[i];
+    qreal y=stopped ? headingY[i] : speedY[i];
+    qreal l=std::sqrt(x*x+y*y);
+    if (l==0) return 0;
+    x/=l;
+    y/=l;
+    if (y==0) return (x>0) ? -90.0 : 90.0;
+    if (y>0) return 180.0-180.0*atan(x/y)/M_PI;
+    return -180.0*atan(x/y)/M_PI;
+}
@@ -0,0 +1,165 @@
+/**
+ * @brief The fleet of drones, stored as arrays of fields and moved by batches.
+ **/
+
+#ifndef DRONESYSTEM_H
+#define DRONESYSTEM_H
+
+#include <serveranddrone.h>
+#include <routing.h>
+#include <vector>
+
+/**
+ * @brief The DroneSystem class: all the drones of the map.
+ *
+ * The fields read at each step (position, speed, destination, state)
+ * are stored in one array per field, padded to whole blocks of drones: the
+ * kinematics of a block is a loop without branch over contiguous floats,
+ * vectorized by the compiler. The name, the target, the current server and the
+ * cached route of each drone are only read when it reaches its destination
+ * (a server or a door), they are stored apart.
+ *
+ * A drone only writes its own fields and the crossing counters of the links
+ * (atomic), the servers and the router are read only: in parallel mode, the
+ * array is split in chunks of whole blocks moved by the threads of the global
+ * pool, with the same results as the serial mode, bit for bit.
+ *
+ * In event-driven mode, the drones are not moved at each step. Between two
+ * waypoints, a drone starts from rest and flies straight toward its destination,
+ * its distance to the destination follows a closed form of the same kinematics
+ * (acceleration, cruise at speedMax, slow down): the time of its arrival is
+ * computed when it leaves, and kept in a priority queue. A step only handles
+ * the drones whose arrival is due; the positions are evaluated on demand.
+ * The drones that are stopped or cruising cost nothing.
+ *
+ * Each drone follows these rules:
+ *  - It moves inside its current server area
+ *  - When reaching a server, it follows the shortest path to the target server
+ *  - Area transitions are done only through edge centers (doors)
+ *  - Speed and orientation are updated smoothly
+ */
+class DroneSystem {
+public:
+    enum class State : quint8 {
+        Idle, ///< no target or outside of the areas of the servers
+        Moving,
+        Arrived ///< stopped on its target server
+    };
+    static const int blockSize=16; ///< drones moved by one iteration of the vectorized kernel
+    static const int parallelThreshold=1<<14; ///< under this number of drones, the parallel mode steps with a single thread
+    static constexpr qreal retryPeriod=1.0; ///< in event-driven mode, time between two queries of a drone waiting at a server (s)
+
+    /**
+     * @brief add: new drone, not moving until attach is called
+     * @return the index of the drone
+     */
+    int add(const QString &name,const Vector2D &position,Server *target);
+    void clear();
+    int size() const { return nDrones; }
+    /**
+     * @brief attach: connect each drone to the server of the area it overflies,
+     * its first destination is that server
+     * @param router gives the next links toward the targets
+     */
+    void attach(QList<Server> &servers,const Router *router);
+    /**
+     * @brief step: moves all the drones
+     * @param dt Time step in seconds.
+     */
+    void step(qreal dt);
+    /**
+     * @brief setParallel: step the drones with the threads of the global pool
+     */
+    void setParallel(bool p) { parallel=p; }
+    bool isParallel() const { return parallel; }
+    /**
+     * @brief setEventDriven: the drones are handled at their arrival times only,
+     * taken into account by the next call of attach
+     */
+    void setEventDriven(bool e) { eventDriven=e; }
+    bool isEventDriven() const { return eventDriven; }
+
+    const QString &getName(int i) const { return cold[i].name; }
+    Server* getTarget(int i) const { return cold[i].target; }
+    Server* getServer(int i) const { return cold[i].connectedTo; }
+    State getState(int i) const { return State(state[i]); }
+    /**
+     * @brief getPosition: in event-driven mode, computed from the time of departure
+     */
+    Vector2D getPosition(int i) const;
+    Vector2D getDestination(int i) const { return Vector2D(destX[i],destY[i]); }
+    /**
+     * @brief getAzimuth: orientation of the drone in degrees, from its speed or from
+     * its speed before it stopped (computed on demand: only the drawing needs it)
+     */
+    qreal getAzimuth(int i) const;
+private:
+    /**
+     * @brief The Cold struct: the fields of a drone that are only read by the events
+     */
+    struct Cold {
+        QString name;
+        Server *target=nullptr;
+        Server *connectedTo=nullptr;
+        QVector<Link*> route; ///< cached route toward the target
+        int routeStep=0; ///< next link of the route
+        const Server *routeServer=nullptr; ///< server where the next link of the route starts
+        int routeTarget=-1;
+        quint32 routeVersion=0;
+    };
+    /**
+     * @brief stepRange: events then kinematics of the drones from first to last (excluded),
+     * first is the beginning of a block
+     */
+    void stepRange(int first,int last,float dt);
+    /**
+     * @brief arrive: the drone #i has reached its destination, choose the next one
+     * (next door toward the target, next server after a door, or stop on the target)
+     */
+    void arrive(int i);
+    /**
+     * @brief nextLink: next link of the route toward the target from the current server.
+     * The route is asked to the router again when the version of the router,
+     * the target or the current server have changed. If the next link or its other
+     * server is down, the backup link of the router is taken instead.
+     */
+    Link* nextLink(Cold &drone);
+    /**
+     * @brief moveBlock: kinematics of the drones of the block that starts at first,
+     * also marks the drones that reach their destination
+     */
+    void moveBlock(int first,float dt);
+    /**
+     * @brief schedule: in event-driven mode, the drone #i leaves its position
+     * toward its destination at time t, pushes its arrival event
+     * @param waiting the drone stays at a server without next link, it asks the router again after retryPeriod
+     */
+    void schedule(int i,qreal t,bool waiting);
+
+    struct Event {
+        qreal time;
+        int drone;
+        bool operator>(const Event& o) const { return time > o.time; }
+    };
+
+    int nDrones=0;
+    bool parallel=false;
+    bool eventDriven=false;
+    qreal now=0; ///< simulated time since attach (s)
+    const Router *routing=nullptr;
+    // hot fields, size rounded up to whole blocks
+    QVector<float> posX,posY;
+    QVector<float> speedX,speedY;
+    QVector<float> destX,destY;
+    QVector<quint8> state; ///< State
+    QVector<quint8> due; ///< 1 if the destination is reached, the drone is handled by arrive at the next step
+    // cold fields
+    QVector<float> headingX,headingY; ///< speed before the last stop, gives the orientation of a stopped drone
+    QVector<Cold> cold;
+    // event-driven mode: the position is the start of the current segment
+    QVector<qreal> segmentStart; ///< time of departure from the position
+    QVector<float> segmentLength; ///< distance from the position to the destination
+    std::vector<Event> events; ///< min-heap of the arrival times, one event per moving drone
+};
+
+#endif // DRONESYSTEM_H
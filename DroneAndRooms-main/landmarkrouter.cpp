@@ -0,0 +1,175 @@
+#include "landmarkrouter.h"
+#include "shortestpath.h"
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace {
+const qreal INF = std::numeric_limits<qreal>::infinity();
+
+// Priority queue item: f is the distance from the source plus the lower bound
+struct Item {
+    qreal f;
+    qreal d;
+    int v;
+    bool operator>(const Item& o) const { return f > o.f; }
+};
+
+/**
+ * @brief The SearchSpace struct: distances of a search, a server is reached
+ * if its stamp is the current generation, so that the array is not cleared
+ * between two queries
+ */
+struct SearchSpace {
+    struct Entry {
+        qreal dist;
+        qreal bound; // lower bound of the distance to the target
+        Link *parent; // link used to reach the server
+        quint32 stamp;
+    };
+    QVector<Entry> entries;
+    quint32 generation=0;
+    std::vector<Item> heap;
+
+    void start(int n) {
+        if (entries.size()!=n) {
+            entries.fill({INF,0,nullptr,0},n);
+            generation=0;
+        }
+        if (++generation==0) {
+            for (auto &e:entries) e.stamp=0;
+            generation=1;
+        }
+        heap.clear();
+    }
+    bool reached(int v) const { return entries[v].stamp==generation; }
+    void push(qreal f,qreal d,int v) {
+        heap.push_back({f,d,v});
+        std::push_heap(heap.begin(),heap.end(),std::greater<Item>());
+    }
+    Item pop() {
+        std::pop_heap(heap.begin(),heap.end(),std::greater<Item>());
+        Item top=heap.back();
+        heap.pop_back();
+        return top;
+    }
+};
+
+const Server* otherServer(Link *l,const Server *from) {
+    return l->getNode1()==from ? l->getNode2() : l->getNode1();
+}
+
+thread_local SearchSpace querySpace;
+}
+
+void LandmarkRouter::build(const QList<Server> &p_servers,int p_nLandmarks) {
+    version++;
+    servers=&p_servers;
+    nServers=p_servers.size();
+    nLandmarks=std::max(0,std::min(p_nLandmarks,nServers));
+    landmarks.clear();
+    distances.fill(-1.0f,qsizetype(nServers)*nLandmarks);
+    if (nLandmarks==0) return;
+
+    // farthest selection: each landmark is the server farthest from the previous ones,
+    // a server that no landmark reaches (other connected part) comes first
+    ShortestPathTree tree;
+    QVector<qreal> nearest(nServers,INF);
+    auto farthest=[&](auto distance) {
+        int best=-1;
+        for (int v=0; v<nServers; v++) {
+            if (p_servers[v].up && (best<0 || distance(v)>distance(best))) best=v;
+        }
+        return best;
+    };
+    tree.run(p_servers.constData(),nServers,0);
+    int next=farthest([&](int v) { return tree.getDistance(v); });
+    while (next>=0 && landmarks.size()<nLandmarks) {
+        int l=landmarks.size();
+        landmarks.push_back(next);
+        tree.run(p_servers.constData(),nServers,next);
+        for (int v=0; v<nServers; v++) {
+            if (tree.isReached(v)) distances[qsizetype(v)*nLandmarks+l]=float(tree.getDistance(v));
+            nearest[v]=std::min(nearest[v],tree.getDistance(v));
+        }
+        next=farthest([&](int v) { return nearest[v]; });
+        if (next>=0 && nearest[next]==0) next=-1; // all the servers are landmarks
+    }
+    if (landmarks.size()<nLandmarks) {
+        qWarning() << "LandmarkRouter: only" << landmarks.size() << "landmarks";
+    }
+}
+
+qreal LandmarkRouter::lowerBound(int v,const float *targetDistances) const {
+    const float *d=distances.constData()+qsizetype(v)*nLandmarks;
+    qreal bound=0;
+    for (int l=0; l<landmarks.size(); l++) {
+        if ((d[l]<0)!=(targetDistances[l]<0)) return INF; // only one of them is reached by the landmark
+        bound=std::max(bound,qreal(std::abs(d[l]-targetDistances[l])));
+    }
+    return bound;
+}
+
+qreal LandmarkRouter::query(int from,int to,QVector<Link*> *route) const {
+    if (route) route->clear();
+    if (from==to) return 0;
+    const float *targetDistances=distances.constData()+qsizetype(to)*nLandmarks;
+    const Server *data=servers->constData();
+    SearchSpace &ws=querySpace;
+    ws.start(nServers);
+    qreal bound=lowerBound(from,targetDistances);
+    if (bound==INF) return -1;
+    ws.entries[from]={0,bound,nullptr,ws.generation};
+    ws.push(bound,0,from);
+
+    // the bounds are consistent: a server is settled when it is popped
+    bool found=false;
+    while (!ws.heap.empty()) {
+        Item cur=ws.pop();
+        if (cur.d!=ws.entries[cur.v].dist) continue;
+        if (cur.v==to) {
+            found=true;
+            break;
+        }
+        const Server *u=&data[cur.v];
+        for (Link *l:u->links) {
+            if (!l->isUsable()) continue;
+            int v=otherServer(l,u)->id;
+            qreal nd=cur.d+l->getDistance();
+            SearchSpace::Entry &e=ws.entries[v];
+            if (!ws.reached(v)) {
+                e={INF,lowerBound(v,targetDistances),nullptr,ws.generation};
+            }
+            if (nd<e.dist && e.bound<INF) {
+                e.dist=nd;
+                e.parent=l;
+                ws.push(nd+e.bound,nd,v);
+            }
+        }
+    }
+    if (!found) return -1;
+
+    if (route) {
+        for (const Server *v=&data[to]; v->id!=from; v=otherServer(ws.entries[v->id].parent,v)) {
+            route->push_back(ws.entries[v->id].parent);
+        }
+        std::reverse(route->begin(),route->end());
+    }
+    return ws.entries[to].dist;
+}
+
+Link* LandmarkRouter::getNextLink(const Server &from,int to) const {
+    QVector<Link*> route;
+    query(from.id,to,&route);
+    return route.isEmpty() ? nullptr : route.first();
+}
+
+QVector<Link*> LandmarkRouter::getRoute(const Server &from,int to) const {
+    QVector<Link*> route;
+    query(from.id,to,&route);
+    return route;
+}
+
+float LandmarkRouter::getDistance(const QList<Server> &,int from,int to) const {
+    return float(query(from,to));
+}
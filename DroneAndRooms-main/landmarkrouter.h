@@ -0,0 +1,59 @@
+/**
+ * @brief A* routing with landmark lower bounds (ALT), for large maps with
+ * a bounded memory.
+ **/
+
+#ifndef LANDMARKROUTER_H
+#define LANDMARKROUTER_H
+
+#include <routing.h>
+
+/**
+ * @brief The LandmarkRouter class: routing engine with O(k.n) memory.
+ *
+ * The distances from k landmark servers to all the servers are computed once,
+ * each new landmark is the server farthest from the previous ones. For any
+ * landmark L, |d(L,t)-d(L,v)| is a lower bound of d(v,t) (triangle inequality),
+ * their maximum guides an A* search from the source toward the target.
+ * The k distances of a server are contiguous, so that a bound reads one cache line.
+ * The routes are computed on demand, the drones cache them (see Router::getVersion).
+ */
+class LandmarkRouter : public Router {
+public:
+    static const int defaultNbLandmarks=16;
+    /**
+     * @brief build: choose the landmarks and compute their distances
+     * @param servers the servers (the id of a server is its index) and their links,
+     * the list is read by the queries: it must stay alive and not move
+     * @param nLandmarks number of landmarks (k)
+     */
+    void build(const QList<Server> &servers,int nLandmarks=defaultNbLandmarks);
+    int size() const { return nServers; }
+    const QVector<int> &getLandmarks() const { return landmarks; }
+    /**
+     * @brief query: A* search from server #from to server #to
+     * @param route if not nullptr, set to the links of the path
+     * @return the length of the path, -1 if server #to is unreachable
+     */
+    qreal query(int from,int to,QVector<Link*> *route=nullptr) const;
+    Link* getNextLink(const Server &from,int to) const override;
+    QVector<Link*> getRoute(const Server &from,int to) const override;
+    float getDistance(const QList<Server> &servers,int from,int to) const override;
+private:
+    /**
+     * @brief lowerBound
+     * @param v a server
+     * @param targetDistances the distances of the target to the landmarks
+     * @return a lower bound of the distance from server #v to the target,
+     * infinite if they are not in the same connected part
+     */
+    qreal lowerBound(int v,const float *targetDistances) const;
+
+    const QList<Server> *servers=nullptr;
+    int nServers=0;
+    int nLandmarks=0;
+    QVector<int> landmarks;
+    QVector<float> distances; ///< distances[v*nLandmarks+l]: from landmark #l to server #v, -1 if unreachable
+};
+
+#endif // LANDMARKROUTER_H
@@ -1,10 +1,15 @@
 #include "mainwindow.h"
+#include "benchmark.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    if (a.arguments().contains("--benchmark")) {
+        runBenchmarks();
+        return 0;
+    }
     MainWindow w;
     w.show();
     return a.exec();
@@ -4,6 +4,12 @@
 #include <QMainWindow>
 #include <QTimer>
 #include <QElapsedTimer>
+#include <simulationclock.h>
+#include <voronoi.h>
+#include <routing.h>
+#include <contractionhierarchy.h>
+#include <landmarkrouter.h>
+#include <congestion.h>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -26,6 +32,10 @@ private slots:
 
     void on_actionMove_drones_triggered();
 
+    void on_actionFaster_triggered();
+
+    void on_actionSlower_triggered();
+
     void on_actionQuit_triggered();
 
     void on_actionCredits_triggered();
@@ -39,32 +49,87 @@ private:
      * @return
      */
     bool loadJson(const QString& title);
-    void createVoronoiMap();
+    /**
+     * @brief Builds the Voronoï area of each server with the selected engine.
+     */
+    void createVoronoiMap(TriangleMesh &mesh,const VoronoiDiagram &voronoi);
 
     /**
      * @brief Builds the server adjacency graph.
      *
-     * For each pair of servers, a link is created if their Voronoï areas
-     * share a common edge. The link length corresponds to the distance
-     * between the two servers through the middle of this shared edge.
+     * A link is created for each pair of servers whose Voronoï areas
+     * share a common edge, found from the edges of the Delaunay mesh.
+     * The link length corresponds to the distance between the two
+     * servers through the middle of this shared edge.
      */
-    void createServersLinks();
+    void createServersLinks(const VoronoiDiagram &voronoi);
 
     /**
-     * @brief Computes all-pairs shortest paths between servers.
+     * @brief Computes the shortest paths between servers.
      *
-     * Uses Dijkstra's algorithm from each server to compute:
+     * Uses Dijkstra's algorithm (in parallel) to compute:
      *  - the minimal distance to every other server
      *  - the first link to take to follow the shortest path
-     * Results are stored in server.bestDistance.
+     * With RoutingEngine::TargetTrees, only the targets of the drones are
+     * the roots of a shortest path tree.
+     * With RoutingEngine::Hierarchy and RoutingEngine::Landmarks, no table is
+     * built: the router answers the queries of the drones, that cache their routes.
+     * The drones read their next link in the selected router.
      */
     void fillDistanceArray();
 
+    /**
+     * @brief simulate: one fixed step of the simulation (drones, congestion)
+     * @param dt simulated time of the step (s)
+     */
+    void simulate(qreal dt);
+    /**
+     * @brief showClock: simulated time and speed in the status bar
+     */
+    void showClock();
+
+    /**
+     * @brief Engine used to build the Voronoï areas, set by the "voronoi" key of the Json file.
+     */
+    enum class VoronoiEngine {
+        Indexed, ///< VoronoiDiagram: circumcenters around each vertex through the mesh neighbours
+        MeshScan ///< buildVoronoiAreasByScan: each server scans all the triangles of the mesh
+    };
+
+    /**
+     * @brief Engine used to route the drones, set by the "routing" key of the Json file.
+     */
+    enum class RoutingEngine {
+        AllPairs, ///< RoutingTable: next hops between all the servers
+        FloydWarshall, ///< RoutingTable: same table, built by a blocked Floyd-Warshall (small dense maps)
+        TargetTrees, ///< RoutingTable: next hops toward the targets of the drones only
+        Hierarchy, ///< ContractionHierarchy: queries without table, for very large maps
+        Landmarks ///< LandmarkRouter: A* queries with O(k.n) memory
+    };
+
+    static const int maxPrintedServers=40; ///< larger distance tables are not printed
+    static constexpr qreal congestionPeriod=1.0; ///< time between two updates of the link costs (s)
+    static const int timerInterval=10; ///< real time between two updates of the simulation (ms)
+    static const int paintInterval=40; ///< minimal real time between two paintings (ms)
+    static constexpr qreal stepBudget=50; ///< real time of the steps of one update (ms), the simulation is late beyond
+    static constexpr qreal repairBudget=10; ///< real time of the repair of the routing table in one update (ms)
+    static constexpr qreal speedFactor=10; ///< change of speed of the Faster and Slower actions
+
     Ui::MainWindow *ui;
-    QVector<QVector<float>> distanceArray;
+    VoronoiEngine voronoiEngine=VoronoiEngine::Indexed;
+    RoutingEngine routingEngine=RoutingEngine::AllPairs;
+    RoutingTable routingTable;
+    ContractionHierarchy hierarchy;
+    LandmarkRouter landmarkRouter;
+    int nLandmarks=LandmarkRouter::defaultNbLandmarks; ///< set by the "landmarks" key of the Json file
+    CongestionControl congestion;
+    bool congestionEnabled=false; ///< set by the "congestion" key of the Json file, RoutingTable engines only
+    qreal congestionTime=0; ///< time since the last update of the link costs (s)
 
     // to animate drones
-    QTimer *timer;
-    QElapsedTimer elapsedTimer;
+    QTimer *timer=nullptr;
+    SimulationClock clock;
+    QElapsedTimer paintTimer;
+    qreal stepCost=0; ///< smoothed real time of one step (ms)
 };
 #endif // MAINWINDOW_H
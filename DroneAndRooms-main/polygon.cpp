@@ -1,71 +1,81 @@
 #include "polygon.h"
 #include <QDebug>
-#include <QStack>
+#include <QtConcurrent>
+#include <numeric>
+#include <algorithm>
 
-bool polarComparison(Vector2D P1,Vector2D P2) {
-    double a1 = asin(P1.y/sqrt(P1.x*P1.x+P1.y*P1.y));
-    if (P1.x<0.0) a1=M_PI-a1;
-    double a2 = asin(P2.y/sqrt(P2.x*P2.x+P2.y*P2.y));
-    if (P2.x<0.0) a2=M_PI-a2;
-    return a1<a2;
-}
-
-Polygon::Polygon(QVector<Vector2D> &points) {
-    assert(points.size()>3);
-    auto p=points.begin();
-    auto pymin=points.begin();
+namespace {
+/// under this size, the points are sorted by a single thread
+const int parallelSortThreshold=1<<16;
 
-    // find point with minimal y and swap with first point
-    while (p!=points.end()) {
-        if (p->y<pymin->y) {
-            pymin=p;
-        }
-        p++;
+/**
+ * @brief parallelSort: the chunks of the array are sorted by the threads of the
+ * global pool, then the sorted runs are merged by pairs
+ */
+template<class T,class Compare>
+void parallelSort(QVector<T> &tab,Compare less) {
+    int n=tab.size();
+    int nChunks=QThreadPool::globalInstance()->maxThreadCount();
+    if (n<parallelSortThreshold || nChunks<2) {
+        std::sort(tab.begin(),tab.end(),less);
+        return;
     }
-    // swap
-    if (pymin!=points.begin()) std::iter_swap(points.begin(), pymin);
-
-    Vector2D origin(points.begin()->x,points.begin()->y);
-    // copy points in a set of points relative to points[0]
-    QVector<Vector2D> pointsRelative;
-    for (auto pOrig:points) {
-        pointsRelative.push_back(Vector2D(pOrig.x-origin.x,pOrig.y-origin.y));
+    T *data=tab.data();
+    QVector<int> bounds;
+    for (int k=0; k<=nChunks; k++) {
+        bounds.push_back(int(qint64(n)*k/nChunks));
     }
+    QVector<int> runs(nChunks);
+    std::iota(runs.begin(),runs.end(),0);
+    QtConcurrent::blockingMap(runs,[&](int k) {
+        std::sort(data+bounds[k],data+bounds[k+1],less);
+    });
+    for (int width=1; width<nChunks; width*=2) {
+        runs.clear();
+        for (int k=0; k+width<nChunks; k+=2*width) runs.push_back(k);
+        QtConcurrent::blockingMap(runs,[&](int k) {
+            std::inplace_merge(data+bounds[k],data+bounds[k+width],data+bounds[qMin(k+2*width,nChunks)],less);
+        });
+    }
+}
+}
 
-    // sorting point with angular criteria
-    std::sort(pointsRelative.begin()+1,
-              pointsRelative.end(),polarComparison);
-
-    QStack<Vector2D*> CHstack;
-    Vector2D *top_1,*top;
-    CHstack.push(&pointsRelative[0]);
-    CHstack.push(&pointsRelative[1]);
-    CHstack.push(&pointsRelative[2]);
+QVector<int> Polygon::convexHull(const QVector<Vector2D> &points) {
+    // lexicographic order, the first index of a duplicated position comes first
+    QVector<int> order(points.size());
+    std::iota(order.begin(),order.end(),0);
+    parallelSort(order,[&points](int a,int b) {
+        const Vector2D &A=points[a], &B=points[b];
+        if (A.x!=B.x) return A.x<B.x;
+        if (A.y!=B.y) return A.y<B.y;
+        return a<b;
+    });
+    order.erase(std::unique(order.begin(),order.end(),[&points](int a,int b) {
+        return points[a]==points[b];
+    }),order.end());
+    if (order.size()<3) return order;
 
-    auto pi=pointsRelative.begin()+3;
-    while (pi!=pointsRelative.end()) {
-        top = CHstack.top();
-        CHstack.pop();
-        top_1 = CHstack.top();
-        CHstack.push(top);
-        while (!isOnTheLeft(&(*pi),top_1,top)) {
-            CHstack.pop();
-            // update values of top and top_1
-            top = CHstack.top();
-            CHstack.pop();
-            top_1 = CHstack.top();
-            CHstack.push(top);
-        }
-        CHstack.push(&(*pi));
-        pi++;
+    // Andrew's monotone chain: lower hull from left to right, then upper hull
+    // from right to left, the vertices which do not make a left turn are removed
+    int n=order.size();
+    QVector<int> hull(2*n);
+    int k=0;
+    for (int i=0; i<n; i++) {
+        while (k>=2 && orient2d(points[hull[k-2]],points[hull[k-1]],points[order[i]])<=0) k--;
+        hull[k++]=order[i];
+    }
+    for (int i=n-2,lowerSize=k+1; i>=0; i--) {
+        while (k>=lowerSize && orient2d(points[hull[k-2]],points[hull[k-1]],points[order[i]])<=0) k--;
+        hull[k++]=order[i];
     }
+    hull.resize(k-1); // the first vertex ends the upper hull
+    return hull;
+}
 
-    // get stack points to create current polygon
-    while (!CHstack.empty()) {
-        tabPts.push_front(*(CHstack.top())+origin);
-        CHstack.pop();
+Polygon::Polygon(const QVector<Vector2D> &points) {
+    for (int i:convexHull(points)) {
+        addVertex(points[i]);
     }
-    tabPts.push_back(tabPts[0]);// polygon propriety (N+1 vertices with P_N=P_0)
     triangulate();
 }
 
@@ -144,8 +154,20 @@ QPair<Vector2D,Vector2D> Polygon::getBoundingBox() const {
     return QPair<Vector2D,Vector2D>(min,max);
 }
 
+void Polygon::triangulateConvex() {
+    int N=nbVertices();
+    for (int i=1; i<N-1; i++) {
+        triangles.push_back(Triangle(tabPts[0],tabPts[i],tabPts[i+1]));
+    }
+}
+
 void Polygon::triangulate() {
-    /// @todo write the code
+    triangles.clear();
+    convex=isConvex();
+    if (convex) {
+        triangulateConvex();
+        return;
+    }
     /// 1. Copy the poly polygon in a temporary version (tmp)
     Polygon tmp(*this);
     QList<Vector2D*> pointListPtr;
@@ -155,7 +177,12 @@ void Polygon::triangulate() {
     /// - does not contain any other vertex
     int i=0;
     auto N=tmp.nbVertices();
+    int nbFails=0; // consecutive vertices that are not an ear
     while (N>=3) {
+        if (nbFails>=N) { // a simple polygon always has an ear
+            qWarning() << "Polygon::triangulate: no ear found, the polygon is not simple";
+            break;
+        }
         Triangle t(tmp[i%N],tmp[(i+1)%N],tmp[(i+2)%N]);
         // fill the list (pointListPtr) with all the vertices of the polygon
         // but the vertices of the triangle.
@@ -172,8 +199,10 @@ void Polygon::triangulate() {
             /// 4. remove middle vertex from the tmp polygon
             tmp.remove((i+1)%N);
             N--;
+            nbFails=0;
         } else {
             i=(i+1)%N;
+            nbFails++;
         }
     }
 }
@@ -7,7 +7,7 @@
 #ifndef POLYGON_H
 #define POLYGON_H
 #include "vector2d.h"
-#include <determinant.h>
+#include <predicates.h>
 #include <QPainter>
 #include <QDebug>
 
@@ -17,8 +17,6 @@
  */
 class Triangle {
     Vector2D tabPts[3]; ///< array of 3 pointers to vertices
-    bool isDelaunay=false; ///< is drawn as Delaunay triangle
-    bool isFlippable=false; ///< is drawn as Delaunay but not flippable triangle
     Vector2D circumCenter; ///< the center of the triangle (by computeCenter)
     float circumRadius; ///< the radius of the circumCircle (by computeCenter)
 public:
@@ -54,10 +52,7 @@ public:
      * @return true if the triangle is Counterclock Wise oriented
      */
     bool isCCW() {
-        Vector2D AB = (tabPts[1])-(tabPts[0]);
-        Vector2D AP = (tabPts[2])-(tabPts[0]);
-        // z component of AB x AP
-        return (AB.x*AP.y-AB.y*AP.x)>0;
+        return orient2d(tabPts[0],tabPts[1],tabPts[2])>0;
     }
     /**
      * @brief contains
@@ -84,10 +79,7 @@ public:
      * @return true if p is on the left of the edge P_iP_{i+1}
      */
     bool isOnTheLeft(const Vector2D &p, int i) const {
-        Vector2D AB = (tabPts[(i+1)%3])-(tabPts[i]);
-        Vector2D AP = p-(tabPts[i]);
-        // z component of AB x AP
-        return (AB.x*AP.y-AB.y*AP.x)>=0;
+        return orient2d(tabPts[i],tabPts[(i+1)%3],p)>=0;
     }
     void print() {
         qDebug() << tabPts[0].x << "," << tabPts[0].y << "/"
@@ -105,22 +97,6 @@ public:
         return 0.005*(AB.x*AC.y-AB.y*AC.x); // convertion to u² unit
     }
 
-    inline void setDelaunay(bool d, bool f) {
-        isDelaunay=d;
-        isFlippable=f;
-    }
-    bool canBeFlipped() {
-        return (!isDelaunay && isFlippable);
-    }
-    bool checkDelaunay(const QVector<Vector2D> &tabVertices) {
-        auto it=tabVertices.begin();
-        while (it!=tabVertices.end() && circleContains(*it)) {
-            it++;
-        }
-        isDelaunay = it==tabVertices.end();
-        isFlippable=false;
-        return isDelaunay;
-    }
     Vector2D getNextVertex(const Vector2D &pt) const {
         if (pt==tabPts[0]) return tabPts[1];
         if (pt==tabPts[1]) return tabPts[2];
@@ -147,21 +123,13 @@ public:
                (tabPts[1]==other.tabPts[0] || tabPts[1]==other.tabPts[1] || tabPts[1]==other.tabPts[2]) &&
                (tabPts[2]==other.tabPts[0] || tabPts[2]==other.tabPts[1] || tabPts[2]==other.tabPts[2]);
     }
-    bool circleContains(const Vector2D&M) {
-        Matrix33 mat;
-        Vector2D A = tabPts[0];
-        Vector2D B = tabPts[1];
-        Vector2D C = tabPts[2];
-        mat.m[0][0] = (A.x - M.x);
-        mat.m[0][1] = (A.y - M.y);
-        mat.m[0][2] = (A.x*A.x-M.x*M.x)+(A.y*A.y-M.y*M.y);
-        mat.m[1][0] = (B.x - M.x);
-        mat.m[1][1] = (B.y - M.y);
-        mat.m[1][2] = (B.x*B.x-M.x*M.x)+(B.y*B.y-M.y*M.y);
-        mat.m[2][0] = (C.x - M.x);
-        mat.m[2][1] = (C.y - M.y);
-        mat.m[2][2] = (C.x*C.x-M.x*M.x)+(C.y*C.y-M.y*M.y);
-        return mat.determinant()<=0; // positive for outside points and equal for A,B,C
+    /**
+     * @brief circleContains
+     * @param M tested point
+     * @return true if M is outside of the circumcircle or on the circle (equal for A,B,C)
+     */
+    bool circleContains(const Vector2D&M) const {
+        return incircle(tabPts[0],tabPts[1],tabPts[2],M)<=0;
     }
     Vector2D getCenter() const {
         return circumCenter;
@@ -206,11 +174,28 @@ private:
     ///< @warning Store N+1 vertices in tabPts array, first is duplicated in last.
     QVector<Vector2D> tabPts; ///< array of vertex positions
     QVector<Triangle> triangles; ///< array of triangles for the triangulation process
+    bool convex=false; ///< set by triangulate, the convex polygons use the fan of P_0
+
+    /**
+     * @brief triangulateConvex: fan triangulation from P_0 in O(n)
+     */
+    void triangulateConvex();
 public:
     /**
-     * @brief Constructor of a polygon.
+     * @brief Constructor of the convex hull of a set of points.
+     * @param points the points, they are not modified
+     */
+    Polygon(const QVector<Vector2D> &points);
+    /**
+     * @brief convexHull: Andrew's monotone chain in O(n log n), the sort is
+     * shared among threads for large sets.
+     * The duplicated points and the points on the middle of a hull edge are
+     * not in the hull.
+     * @param points the points
+     * @return the indices of the CCW vertices of the hull, less than 3 indices if
+     * all the points are aligned
      */
-    Polygon(QVector<Vector2D> &points);
+    static QVector<int> convexHull(const QVector<Vector2D> &points);
     Polygon() {}
     void remove(int i) {
         assert(i>=0 && i<tabPts.size()-1);
@@ -260,6 +245,7 @@ public:
     void draw(QPainter &painter) const;
     /**
      * @brief triangulate the polygon and store triangles in "triangles" array.
+     * A convex polygon is cut in a fan of triangles, the others by ear clipping.
      */
     void triangulate();
 
@@ -270,10 +256,7 @@ public:
      * @return true if p is on the left of the edge P_iP_{i+1}
      */
     bool isOnTheLeft(const Vector2D &p, int i) const {
-        Vector2D AB = tabPts[i+1]-tabPts[i];
-        Vector2D AP = p-tabPts[i];
-        // z component of AB x AP
-        return (AB.x*AP.y-AB.y*AP.x)>=0;
+        return orient2d(tabPts[i],tabPts[i+1],p)>=0;
     }
     /**
      * @brief isOnTheLeft
@@ -283,8 +266,7 @@ public:
      * @return true if Ap is on the left of [AB]
      */
     bool isOnTheLeft(const Vector2D *p,const Vector2D *A,const Vector2D *B) {
-        Vector2D AB = *B-*A,AP = *p-*A;
-        return (AB.x*AP.y - AB.y*AP.x)>=0;
+        return orient2d(*A,*B,*p)>=0;
     }
     /**
      * @brief isConvex
@@ -326,7 +308,28 @@ public:
         tabPts.insert(index,p);
         tabPts[tabPts.size()-1]=tabPts[0];
     }
-    bool contains(const Vector2D& pt) {
+    /**
+     * @brief contains
+     * @warning the polygon must be triangulated
+     * @return true if pt is inside the polygon or on its border,
+     * in O(log n) for a convex polygon (binary search of the wedge of the fan containing pt)
+     */
+    bool contains(const Vector2D& pt) const {
+        int N=nbVertices();
+        if (convex) {
+            // pt must be in the angle P_1P_0P_{N-1}
+            if (orient2d(tabPts[0],tabPts[1],pt)<0 || orient2d(tabPts[0],tabPts[N-1],pt)>0) return false;
+            int first=1,last=N-1; // pt is between the rays P_0P_first and P_0P_last
+            while (last-first>1) {
+                int mid=(first+last)/2;
+                if (orient2d(tabPts[0],tabPts[mid],pt)>=0) {
+                    first=mid;
+                } else {
+                    last=mid;
+                }
+            }
+            return orient2d(tabPts[first],tabPts[first+1],pt)>=0;
+        }
         auto t = triangles.begin();
         while (t!=triangles.end() && !t->contains(pt)) {
             t++;
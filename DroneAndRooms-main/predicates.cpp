@@ -0,0 +1,323 @@
+#include "predicates.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+const double epsilon=1.1102230246251565e-16; // 2^-53
+const double splitter=134217729.0; // 2^27+1
+const double resultErrBound=(3.0+8.0*epsilon)*epsilon;
+const double ccwErrBoundA=(3.0+16.0*epsilon)*epsilon;
+const double ccwErrBoundB=(2.0+12.0*epsilon)*epsilon;
+const double ccwErrBoundC=(9.0+64.0*epsilon)*epsilon*epsilon;
+const double iccErrBoundA=(10.0+96.0*epsilon)*epsilon;
+const double iccErrBoundB=(4.0+48.0*epsilon)*epsilon;
+
+/**
+ * @brief The Expansion struct: sum of non-overlapping doubles, sorted by increasing
+ * magnitude, stored on the stack. N is the maximal number of components, known from
+ * the operations that built the expansion, so that no evaluation allocates.
+ */
+template<int N>
+struct Expansion {
+    int length=0;
+    double c[N];
+};
+
+/**
+ * @brief twoDiff: a-b = x+y exactly
+ */
+inline void twoDiff(double a,double b,double &x,double &y) {
+    x=a-b;
+    double bv=a-x;
+    double av=x+bv;
+    double br=bv-b;
+    double ar=a-av;
+    y=ar+br;
+}
+
+/**
+ * @brief twoSum: a+b = x+y exactly
+ */
+inline void twoSum(double a,double b,double &x,double &y) {
+    x=a+b;
+    double bv=x-a;
+    double av=x-bv;
+    y=(a-av)+(b-bv);
+}
+
+inline void split(double a,double &hi,double &lo) {
+    double c=splitter*a;
+    double abig=c-a;
+    hi=c-abig;
+    lo=a-hi;
+}
+
+/**
+ * @brief twoProduct: a*b = x+y exactly
+ */
+inline void twoProduct(double a,double b,double &x,double &y) {
+    x=a*b;
+    double ahi,alo,bhi,blo;
+    split(a,ahi,alo);
+    split(b,bhi,blo);
+    double err1=x-(ahi*bhi);
+    double err2=err1-(alo*bhi);
+    double err3=err2-(ahi*blo);
+    y=(alo*blo)-err3;
+}
+
+/**
+ * @brief sumZeroElim: h=e+f (Shewchuk's fast_expansion_sum_zeroelim),
+ * h has room for elen+flen components
+ * @return the length of h, without zero components (at least 1)
+ */
+int sumZeroElim(int elen,const double *e,int flen,const double *f,double *h) {
+    int ei=0, fi=0, hi=0;
+    double Q;
+    // the components are merged by increasing magnitude
+    if ((f[0]>e[0])==(f[0]>-e[0])) Q=e[ei++];
+    else Q=f[fi++];
+    while (ei<elen || fi<flen) {
+        double next;
+        if (fi==flen || (ei<elen && (f[fi]>e[ei])==(f[fi]>-e[ei]))) next=e[ei++];
+        else next=f[fi++];
+        double x,y;
+        twoSum(Q,next,x,y);
+        Q=x;
+        if (y!=0.0) h[hi++]=y;
+    }
+    if (Q!=0.0 || hi==0) h[hi++]=Q;
+    return hi;
+}
+
+/**
+ * @brief scaleZeroElim: h=e*b (Shewchuk's scale_expansion_zeroelim), h has room for 2*elen components
+ * @return the length of h, without zero components (at least 1)
+ */
+int scaleZeroElim(int elen,const double *e,double b,double *h) {
+    int hi=0;
+    double Q,hh;
+    twoProduct(e[0],b,Q,hh);
+    if (hh!=0.0) h[hi++]=hh;
+    for (int i=1; i<elen; i++) {
+        double T,t,s;
+        twoProduct(e[i],b,T,t);
+        twoSum(Q,t,s,hh);
+        if (hh!=0.0) h[hi++]=hh;
+        Q=T+s; // fast two sum, |T|>=|s|
+        hh=s-(Q-T);
+        if (hh!=0.0) h[hi++]=hh;
+    }
+    if (Q!=0.0 || hi==0) h[hi++]=Q;
+    return hi;
+}
+
+template<int N,int M>
+Expansion<N+M> sum(const Expansion<N> &e,const Expansion<M> &f) {
+    Expansion<N+M> h;
+    h.length=sumZeroElim(e.length,e.c,f.length,f.c,h.c);
+    return h;
+}
+
+template<int N>
+Expansion<2*N> scale(const Expansion<N> &e,double b) {
+    Expansion<2*N> h;
+    h.length=scaleZeroElim(e.length,e.c,b,h.c);
+    return h;
+}
+
+/**
+ * @brief product: e*f, sum of the scaled expansions e*f[i]
+ */
+template<int N,int M>
+Expansion<2*N*M> product(const Expansion<N> &e,const Expansion<M> &f) {
+    // the partial sum after k components has at most 2*N*k components
+    Expansion<2*N*M> h,tmp;
+    Expansion<2*N*M> *cur=&h, *next=&tmp;
+    cur->length=scaleZeroElim(e.length,e.c,f.c[0],cur->c);
+    for (int i=1; i<f.length; i++) {
+        Expansion<2*N> s=scale(e,f.c[i]);
+        next->length=sumZeroElim(cur->length,cur->c,s.length,s.c,next->c);
+        std::swap(cur,next);
+    }
+    if (cur!=&h) {
+        h.length=tmp.length;
+        std::copy(tmp.c,tmp.c+tmp.length,h.c);
+    }
+    return h;
+}
+
+template<int N>
+Expansion<N> negate(Expansion<N> e) {
+    for (int i=0; i<e.length; i++) e.c[i]=-e.c[i];
+    return e;
+}
+
+Expansion<2> difference(double a,double b) {
+    Expansion<2> h;
+    twoDiff(a,b,h.c[1],h.c[0]);
+    h.length=2;
+    return h;
+}
+
+/**
+ * @brief twoProductDiff: a*b-c*d exactly
+ */
+Expansion<4> twoProductDiff(double a,double b,double c,double d) {
+    Expansion<2> p,q;
+    twoProduct(a,b,p.c[1],p.c[0]);
+    twoProduct(c,d,q.c[1],q.c[0]);
+    p.length=q.length=2;
+    return sum(p,negate(q));
+}
+
+/**
+ * @brief approximate: sum of the components, close to the value of the expansion
+ */
+template<int N>
+double approximate(const Expansion<N> &e) {
+    double s=0.0;
+    for (int i=0; i<e.length; i++) s+=e.c[i];
+    return s;
+}
+
+/**
+ * @brief top: the most significant component has the sign of the expansion
+ */
+template<int N>
+double top(const Expansion<N> &e) {
+    return e.c[e.length-1];
+}
+
+/**
+ * @brief orient2dAdapt: stages B, C and D of Shewchuk's orient2d, called when the
+ * fast filter (stage A) cannot decide the sign.
+ * B: exact determinant of the rounded differences, C: first order correction by
+ * the tails of the differences, D: exact determinant.
+ */
+double orient2dAdapt(double ax,double ay,double bx,double by,double cx,double cy,double detsum) {
+    double acx=ax-cx, bcx=bx-cx;
+    double acy=ay-cy, bcy=by-cy;
+    Expansion<4> B=twoProductDiff(acx,bcy,acy,bcx);
+    double det=approximate(B);
+    double errbound=ccwErrBoundB*detsum;
+    if (det>=errbound || -det>=errbound) return det;
+
+    double acxtail,acytail,bcxtail,bcytail,x;
+    twoDiff(ax,cx,x,acxtail);
+    twoDiff(bx,cx,x,bcxtail);
+    twoDiff(ay,cy,x,acytail);
+    twoDiff(by,cy,x,bcytail);
+    // the differences are exact: B is the exact determinant
+    if (acxtail==0.0 && acytail==0.0 && bcxtail==0.0 && bcytail==0.0) return top(B);
+
+    errbound=ccwErrBoundC*detsum+resultErrBound*std::fabs(det);
+    det+=(acx*bcytail+bcy*acxtail)-(acy*bcxtail+bcx*acytail);
+    if (det>=errbound || -det>=errbound) return det;
+
+    Expansion<8> C1=sum(B,twoProductDiff(acxtail,bcy,acytail,bcx));
+    Expansion<12> C2=sum(C1,twoProductDiff(acx,bcytail,acy,bcxtail));
+    Expansion<16> D=sum(C2,twoProductDiff(acxtail,bcytail,acytail,bcxtail));
+    return top(D);
+}
+
+double incircleExact(double ax,double ay,double bx,double by,double cx,double cy,double dx,double dy) {
+    Expansion<2> adx=difference(ax,dx), ady=difference(ay,dy);
+    Expansion<2> bdx=difference(bx,dx), bdy=difference(by,dy);
+    Expansion<2> cdx=difference(cx,dx), cdy=difference(cy,dy);
+
+    Expansion<16> alift=sum(product(adx,adx),product(ady,ady));
+    Expansion<16> blift=sum(product(bdx,bdx),product(bdy,bdy));
+    Expansion<16> clift=sum(product(cdx,cdx),product(cdy,cdy));
+
+    Expansion<16> bc=sum(product(bdx,cdy),negate(product(cdx,bdy)));
+    Expansion<16> ca=sum(product(cdx,ady),negate(product(adx,cdy)));
+    Expansion<16> ab=sum(product(adx,bdy),negate(product(bdx,ady)));
+
+    Expansion<1024> abDet=sum(product(alift,bc),product(blift,ca));
+    return top(sum(abDet,product(clift,ab)));
+}
+
+/**
+ * @brief incircleAdapt: stages B and D of Shewchuk's incircle, called when the
+ * fast filter (stage A) cannot decide the sign.
+ * B: exact determinant of the rounded differences, it is final when the differences
+ * are exact (integer coordinates of the servers). The first order correction of
+ * stage C is not computed, the other cases go to the exact evaluation (D).
+ */
+double incircleAdapt(double ax,double ay,double bx,double by,double cx,double cy,double dx,double dy,double permanent) {
+    double adx=ax-dx, bdx=bx-dx, cdx=cx-dx;
+    double ady=ay-dy, bdy=by-dy, cdy=cy-dy;
+
+    Expansion<4> bc=twoProductDiff(bdx,cdy,cdx,bdy);
+    Expansion<32> adet=sum(scale(scale(bc,adx),adx),scale(scale(bc,ady),ady));
+    Expansion<4> ca=twoProductDiff(cdx,ady,adx,cdy);
+    Expansion<32> bdet=sum(scale(scale(ca,bdx),bdx),scale(scale(ca,bdy),bdy));
+    Expansion<4> ab=twoProductDiff(adx,bdy,bdx,ady);
+    Expansion<32> cdet=sum(scale(scale(ab,cdx),cdx),scale(scale(ab,cdy),cdy));
+    Expansion<96> fin=sum(sum(adet,bdet),cdet);
+
+    double det=approximate(fin);
+    double errbound=iccErrBoundB*permanent;
+    if (det>=errbound || -det>=errbound) return det;
+
+    double tail,x;
+    bool exactDifferences=true;
+    for (auto p:{std::make_pair(ax,dx),std::make_pair(bx,dx),std::make_pair(cx,dx),
+                 std::make_pair(ay,dy),std::make_pair(by,dy),std::make_pair(cy,dy)}) {
+        twoDiff(p.first,p.second,x,tail);
+        if (tail!=0.0) exactDifferences=false;
+    }
+    if (exactDifferences) return top(fin);
+
+    return incircleExact(ax,ay,bx,by,cx,cy,dx,dy);
+}
+}
+
+double orient2d(const Vector2D &a,const Vector2D &b,const Vector2D &c) {
+    double detleft=(double(a.x)-c.x)*(double(b.y)-c.y);
+    double detright=(double(a.y)-c.y)*(double(b.x)-c.x);
+    double det=detleft-detright;
+    double detsum;
+
+    // fast filter: the sign is certain if the terms have opposite signs
+    // or if the determinant is greater than the error bound
+    if (detleft>0.0) {
+        if (detright<=0.0) return det;
+        detsum=detleft+detright;
+    } else if (detleft<0.0) {
+        if (detright>=0.0) return det;
+        detsum=-detleft-detright;
+    } else {
+        return det;
+    }
+    double errbound=ccwErrBoundA*detsum;
+    if (det>=errbound || -det>=errbound) return det;
+
+    return orient2dAdapt(a.x,a.y,b.x,b.y,c.x,c.y,detsum);
+}
+
+double incircle(const Vector2D &a,const Vector2D &b,const Vector2D &c,const Vector2D &d) {
+    double adx=double(a.x)-d.x, ady=double(a.y)-d.y;
+    double bdx=double(b.x)-d.x, bdy=double(b.y)-d.y;
+    double cdx=double(c.x)-d.x, cdy=double(c.y)-d.y;
+
+    double bdxcdy=bdx*cdy, cdxbdy=cdx*bdy;
+    double alift=adx*adx+ady*ady;
+    double cdxady=cdx*ady, adxcdy=adx*cdy;
+    double blift=bdx*bdx+bdy*bdy;
+    double adxbdy=adx*bdy, bdxady=bdx*ady;
+    double clift=cdx*cdx+cdy*cdy;
+
+    double det=alift*(bdxcdy-cdxbdy)+blift*(cdxady-adxcdy)+clift*(adxbdy-bdxady);
+
+    // fast filter
+    double permanent=(fabs(bdxcdy)+fabs(cdxbdy))*alift
+                     +(fabs(cdxady)+fabs(adxcdy))*blift
+                     +(fabs(adxbdy)+fabs(bdxady))*clift;
+    double errbound=iccErrBoundA*permanent;
+    if (det>errbound || -det>errbound) return det;
+
+    return incircleAdapt(a.x,a.y,b.x,b.y,c.x,c.y,d.x,d.y,permanent);
+}
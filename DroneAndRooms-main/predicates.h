@@ -0,0 +1,33 @@
+/**
+ * @brief Robust geometric predicates for the triangulation.
+ *
+ * The tests are first evaluated in double precision with an error bound
+ * (fast filter). When the result is too close to zero to be trusted, the
+ * determinant is computed exactly with floating-point expansions
+ * (J.R. Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast
+ * Robust Geometric Predicates", 1997), so that the sign is always correct.
+ **/
+
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include "vector2d.h"
+
+/**
+ * @brief orient2d: orientation of the triangle (a,b,c)
+ * @return a positive value if (a,b,c) is CCW (c on the left of [ab]),
+ * a negative value if it is CW and zero if the points are collinear.
+ * Only the sign is exact.
+ */
+double orient2d(const Vector2D &a,const Vector2D &b,const Vector2D &c);
+
+/**
+ * @brief incircle: position of d relative to the circumcircle of (a,b,c)
+ * @warning (a,b,c) must be CCW
+ * @return a positive value if d is inside the circle, a negative value
+ * if it is outside and zero if the four points are cocircular.
+ * Only the sign is exact.
+ */
+double incircle(const Vector2D &a,const Vector2D &b,const Vector2D &c,const Vector2D &d);
+
+#endif // PREDICATES_H
@@ -0,0 +1,651 @@
+#include "routing.h"
+#include "shortestpath.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <numeric>
+#include <algorithm>
+#include <limits>
+
+namespace {
+const qreal INF = std::numeric_limits<qreal>::infinity();
+
+// Priority queue item
+struct Item {
+    qreal d;
+    int v;
+    bool operator>(const Item& o) const { return d > o.d; }
+};
+
+// Helper: returns the opposite server of a link
+const Server* otherServer(Link* l, const Server* from) {
+    if (!l || !from) return nullptr;
+    if (l->getNode1() == from) return l->getNode2();
+    if (l->getNode2() == from) return l->getNode1();
+    return nullptr;
+}
+
+// cost of a link for the routing, infinite if it cannot be used
+qreal cost(const Link *l) {
+    return l->isUsable() ? l->getDistance() : INF;
+}
+
+quint8 toPort(int index) {
+    return (index>=0 && index<RoutingTable::maxPorts) ? quint8(index) : RoutingTable::noPort;
+}
+
+/**
+ * @brief fillRow: next hops from the source of the tree toward every server,
+ * the first links are carried by the tree
+ * @param distanceRow row of the distances, nullptr if they are not kept
+ */
+void fillRow(int nServers,const ShortestPathTree &tree,quint8 *portRow,float *distanceRow) {
+    for (int dstId = 0; dstId < nServers; ++dstId) {
+        if (distanceRow) distanceRow[dstId] = (tree.isReached(dstId) ? float(tree.getDistance(dstId)) : -1.0f);
+        portRow[dstId] = toPort(tree.getFirstLinkIndex(dstId));
+    }
+}
+
+/**
+ * @brief fillColumn: next hops from every server toward the root of the tree,
+ * the links are undirected so the next hop of a server is the link to its parent
+ */
+void fillColumn(const Server *servers,int nServers,const ShortestPathTree &tree,quint8 *portColumn,float *distanceColumn) {
+    for (int v = 0; v < nServers; ++v) {
+        distanceColumn[v] = (tree.isReached(v) ? float(tree.getDistance(v)) : -1.0f);
+        Link *parent = tree.getParentLink(v);
+        portColumn[v] = parent ? toPort(servers[v].links.indexOf(parent)) : RoutingTable::noPort;
+    }
+}
+
+/**
+ * @brief The RepairWorkspace struct: the servers touched by the repair of one
+ * column, a server is touched if its stamp is the current generation
+ */
+struct RepairWorkspace {
+    QVector<qreal> dist; // new distance to the target of the touched servers
+    QVector<quint32> stamp;
+    quint32 generation=0;
+    QVector<int> touched; // touched servers
+    QVector<quint8> oldPorts; // next hop of the touched servers before the repair
+    QVector<int> subtree; // servers whose next hops lead through an increased link
+    QVector<quint32> backupStamp; // servers whose backup is up to date
+    std::vector<Item> heap;
+};
+
+/**
+ * @brief The Column struct: the next hops and distances of all the servers
+ * toward one target, the entry of server v is base+v*stride
+ */
+struct Column {
+    quint8 *ports;
+    float *distances;
+    quint8 *backups; // nullptr if the backup ports are not kept
+    qsizetype base;
+    qsizetype stride;
+    quint8 &port(int v) const { return ports[base+v*stride]; }
+    float &distance(int v) const { return distances[base+v*stride]; }
+    quint8 &backup(int v) const { return backups[base+v*stride]; }
+};
+
+/**
+ * @brief backupPort: loop-free alternate of server #v toward the target of the column,
+ * a usable link other than the next hop toward a neighbour strictly closer to the target.
+ * The neighbours whose own next hop does not lead to the primary next server come first
+ * (they also protect against the failure of that server), then the shortest paths.
+ */
+quint8 backupPort(const Server *servers,const Column &col,int v) {
+    float dv=col.distance(v);
+    quint8 primary=col.port(v);
+    if (dv<=0 || primary==RoutingTable::noPort) return RoutingTable::noPort;
+    const Server &u=servers[v];
+    const Server *next=otherServer(u.links[primary],&u);
+    quint8 best=RoutingTable::noPort;
+    bool bestProtects=false;
+    qreal bestLength=INF;
+    for (int p=0; p<u.links.size() && p<RoutingTable::maxPorts; p++) {
+        Link *l=u.links[p];
+        if (p==primary || !l->isUsable()) continue;
+        const Server *w=otherServer(l,&u);
+        float dw=col.distance(w->id);
+        if (dw<0 || !(dw<dv)) continue; // not downstream: the path of w may come back to v
+        quint8 wp=col.port(w->id);
+        bool protects=w!=next && (wp==RoutingTable::noPort || otherServer(w->links[wp],w)!=next);
+        qreal length=l->getDistance()+dw;
+        if (protects>bestProtects || (protects==bestProtects && length<bestLength)) {
+            best=quint8(p);
+            bestProtects=protects;
+            bestLength=length;
+        }
+    }
+    return best;
+}
+
+// true if the distance nd is shorter than cur by more than the rounding errors of the stored floats
+bool improves(qreal nd,qreal cur) {
+    return cur==INF ? nd<INF : nd<cur-1e-6*cur;
+}
+
+/**
+ * @brief repairColumn: update the next hops toward one target after the changes
+ * of some links, the other columns are not read
+ * @return the number of next hops that have changed
+ */
+int repairColumn(const Server *servers,int nServers,const Column &col,
+                 const QVector<QPair<Link*,qreal>> &changes,RepairWorkspace &ws) {
+    // is the column affected?
+    auto storedDistance=[&](int v) { float d=col.distance(v); return d<0 ? INF : qreal(d); };
+    auto usesLink=[&](int v,const Link *l) {
+        quint8 p=col.port(v);
+        return p!=RoutingTable::noPort && servers[v].links[p]==l;
+    };
+    bool affected=false;
+    for (auto &change:changes) {
+        Link *l=change.first;
+        int a=l->getNode1()->id,b=l->getNode2()->id;
+        qreal newCost=cost(l);
+        if (newCost>change.second) {
+            affected = usesLink(a,l) || usesLink(b,l);
+        } else if (newCost<change.second) {
+            affected = improves(storedDistance(a)+newCost,storedDistance(b)) ||
+                       improves(storedDistance(b)+newCost,storedDistance(a));
+        }
+        if (affected) break;
+    }
+    if (!affected) {
+        // same distances, only the links of the two ends have changed
+        if (col.backups) {
+            for (auto &change:changes) {
+                for (const Server *v:{change.first->getNode1(),change.first->getNode2()}) {
+                    col.backup(v->id)=backupPort(servers,col,v->id);
+                }
+            }
+        }
+        return 0;
+    }
+
+    if (ws.dist.size()!=nServers) {
+        ws.dist.resize(nServers);
+        ws.stamp.fill(0,nServers);
+        ws.backupStamp.fill(0,nServers);
+    }
+    if (++ws.generation==0) { // wrap around of the stamps
+        ws.stamp.fill(0);
+        ws.backupStamp.fill(0);
+        ws.generation=1;
+    }
+    ws.touched.clear();
+    ws.oldPorts.clear();
+    ws.heap.clear();
+    auto distance=[&](int v) { return ws.stamp[v]==ws.generation ? ws.dist[v] : storedDistance(v); };
+    auto setEntry=[&](int v,qreal d,quint8 port) {
+        if (ws.stamp[v]!=ws.generation) {
+            ws.stamp[v]=ws.generation;
+            ws.touched.push_back(v);
+            ws.oldPorts.push_back(col.port(v));
+        }
+        ws.dist[v]=d;
+        col.distance(v)=(d==INF ? -1.0f : float(d));
+        col.port(v)=port;
+    };
+
+    // servers below an increased link of the tree: reset
+    ws.subtree.clear();
+    for (auto &change:changes) {
+        Link *l=change.first;
+        if (cost(l)<=change.second) continue;
+        for (int v:{l->getNode1()->id,l->getNode2()->id}) {
+            if (ws.stamp[v]!=ws.generation && usesLink(v,l)) {
+                setEntry(v,INF,RoutingTable::noPort);
+                ws.subtree.push_back(v);
+            }
+        }
+    }
+    // the children of a server are the neighbours whose next hop is the common link
+    for (int i=0; i<ws.subtree.size(); i++) {
+        const Server &u=servers[ws.subtree[i]];
+        for (Link *l:u.links) {
+            int w=otherServer(l,&u)->id;
+            if (ws.stamp[w]!=ws.generation && usesLink(w,l)) {
+                setEntry(w,INF,RoutingTable::noPort);
+                ws.subtree.push_back(w);
+            }
+        }
+    }
+    // best neighbour of the reset servers outside of the subtree
+    for (int v:ws.subtree) {
+        const Server &u=servers[v];
+        for (int p=0; p<u.links.size(); p++) {
+            Link *l=u.links[p];
+            if (!l->isUsable()) continue;
+            qreal nd=distance(otherServer(l,&u)->id)+l->getDistance();
+            if (improves(nd,ws.dist[v])) setEntry(v,nd,toPort(p));
+        }
+        if (ws.dist[v]<INF) ws.heap.push_back({ws.dist[v],v});
+    }
+    // the ends of the decreased links propagate their distance
+    for (auto &change:changes) {
+        Link *l=change.first;
+        if (cost(l)>=change.second) continue;
+        for (int v:{l->getNode1()->id,l->getNode2()->id}) {
+            if (distance(v)<INF) ws.heap.push_back({distance(v),v});
+        }
+    }
+    std::make_heap(ws.heap.begin(),ws.heap.end(),std::greater<Item>());
+
+    // local Dijkstra, only the improved servers are visited
+    while (!ws.heap.empty()) {
+        std::pop_heap(ws.heap.begin(),ws.heap.end(),std::greater<Item>());
+        Item cur=ws.heap.back();
+        ws.heap.pop_back();
+        if (cur.d!=distance(cur.v)) continue;
+        const Server *u=&servers[cur.v];
+        for (Link *l:u->links) {
+            if (!l->isUsable()) continue;
+            const Server *vS=otherServer(l,u);
+            qreal nd=cur.d+l->getDistance();
+            if (improves(nd,distance(vS->id))) {
+                setEntry(vS->id,nd,toPort(vS->links.indexOf(l)));
+                ws.heap.push_back({nd,vS->id});
+                std::push_heap(ws.heap.begin(),ws.heap.end(),std::greater<Item>());
+            }
+        }
+    }
+
+    int changed=0;
+    for (int i=0; i<ws.touched.size(); i++) {
+        if (col.port(ws.touched[i])!=ws.oldPorts[i]) changed++;
+    }
+    // the backup of a server depends on its links and on the entries of its neighbours
+    if (col.backups) {
+        auto refreshBackup=[&](int v) {
+            if (ws.backupStamp[v]==ws.generation) return;
+            ws.backupStamp[v]=ws.generation;
+            col.backup(v)=backupPort(servers,col,v);
+        };
+        for (int v:ws.touched) {
+            refreshBackup(v);
+            for (Link *l:servers[v].links) refreshBackup(otherServer(l,&servers[v])->id);
+        }
+        for (auto &change:changes) {
+            refreshBackup(change.first->getNode1()->id);
+            refreshBackup(change.first->getNode2()->id);
+        }
+    }
+    return changed;
+}
+}
+
+void RoutingTable::checkPorts(const QList<Server> &servers) {
+    nServers = servers.size();
+    for (auto &s:servers) {
+        if (s.links.size()>maxPorts) {
+            qWarning() << "RoutingTable: server" << s.name << "has" << s.links.size() << "links, only"
+                       << maxPorts << "can be used as next hops";
+        }
+    }
+}
+
+QVector<Link*> Router::getRoute(const Server &from,int to) const {
+    QVector<Link*> route;
+    const Server *cur=&from;
+    while (cur->id!=to) {
+        Link *l=getNextLink(*cur,to);
+        if (!l) return {};
+        route.push_back(l);
+        cur=otherServer(l,cur);
+    }
+    return route;
+}
+
+void RoutingTable::clear() {
+    version++;
+    pendingChanges.clear();
+    nServers=0;
+    // QVector::clear keeps the capacity: the n² arrays are released by assignment
+    ports=QVector<quint8>();
+    distances=QVector<float>();
+    backupPorts=QVector<quint8>();
+    targetColumns.clear();
+}
+
+void RoutingTable::buildBackups(const QList<Server> &servers) {
+    backupPorts.resize(ports.size());
+    backupPorts.squeeze();
+    const Server *data=servers.constData();
+    quint8 *portData=ports.data();
+    float *distanceData=distances.data();
+    quint8 *backupData=backupPorts.data();
+    int n=nServers;
+
+    // row by row: the rows of the neighbours are read sequentially
+    QVector<int> sources(nServers);
+    std::iota(sources.begin(),sources.end(),0);
+    QtConcurrent::blockingMap(sources,[=](int srcId) {
+        for (int t=0; t<n; t++) {
+            backupData[qsizetype(srcId)*n+t]=backupPort(data,{portData,distanceData,backupData,t,n},srcId);
+        }
+    });
+}
+
+void RoutingTable::build(const QList<Server> &servers,bool keepDistances) {
+    version++;
+    pendingChanges.clear(); // the new table uses the current costs
+    mode = Mode::AllPairs;
+    checkPorts(servers);
+    targetColumns.clear();
+    ports.resize(qsizetype(nServers)*nServers);
+    distances.resize(keepDistances?qsizetype(nServers)*nServers:0);
+    ports.squeeze();
+    distances.squeeze();
+    const Server *data=servers.constData();
+    quint8 *portData=ports.data();
+    float *distanceData=keepDistances?distances.data():nullptr;
+    int n=nServers;
+
+    QVector<int> sources(nServers);
+    std::iota(sources.begin(),sources.end(),0);
+    QtConcurrent::blockingMap(sources,[=](int srcId) {
+        thread_local ShortestPathTree tree;
+        qsizetype row=qsizetype(srcId)*n;
+        tree.run(data,n,srcId);
+        fillRow(n,tree,portData+row,distanceData?distanceData+row:nullptr);
+    });
+    if (keepDistances) buildBackups(servers);
+    else backupPorts.clear();
+}
+
+void RoutingTable::buildTargets(const QList<Server> &servers,const QVector<int> &targets) {
+    finishRepair(servers);
+    if (mode!=Mode::TargetTrees || nServers!=servers.size()) {
+        version++;
+        mode = Mode::TargetTrees;
+        targetColumns.clear();
+        ports.clear();
+        distances.clear();
+        backupPorts.clear();
+    }
+    checkPorts(servers);
+    // new columns for the targets that are not cached yet
+    QVector<int> newTargets;
+    for (int t:targets) {
+        if (t>=0 && t<nServers && !targetColumns.contains(t)) {
+            targetColumns.insert(t,targetColumns.size());
+            newTargets.push_back(t);
+        }
+    }
+    if (newTargets.isEmpty()) return;
+    version++; // the routes toward the new targets were empty
+    ports.resize(qsizetype(targetColumns.size())*nServers);
+    distances.resize(qsizetype(targetColumns.size())*nServers);
+    backupPorts.resize(qsizetype(targetColumns.size())*nServers);
+    const Server *data=servers.constData();
+    quint8 *portData=ports.data();
+    float *distanceData=distances.data();
+    quint8 *backupData=backupPorts.data();
+    int n=nServers;
+    const QHash<int,int> &columns=targetColumns;
+
+    QtConcurrent::blockingMap(newTargets,[=,&columns](int target) {
+        thread_local ShortestPathTree tree;
+        qsizetype column=qsizetype(columns.value(target))*n;
+        tree.run(data,n,target);
+        fillColumn(data,n,tree,portData+column,distanceData+column);
+        Column col{portData,distanceData,backupData,column,1};
+        for (int v=0; v<n; v++) col.backup(v)=backupPort(data,col,v);
+    });
+}
+
+namespace {
+const int floydWarshallBlock=64; ///< side of the blocks, 3 blocks of floats fit in a L2 cache
+
+/**
+ * @brief relaxRow: Floyd-Warshall step of one row of a block through server k,
+ * fixed length and no aliasing: the compiler vectorizes it
+ */
+void relaxRow(float *__restrict distI,quint8 *__restrict nextI,const float *__restrict distK,float dik,quint8 nik) {
+    for (int j=0; j<floydWarshallBlock; j++) {
+        float cur=distI[j];
+        float d=dik+distK[j];
+        quint8 keep=quint8(-quint8(!(d<cur))); // 0xFF if the path through k is not shorter
+        distI[j]=std::min(cur,d);
+        nextI[j]=(nextI[j]&keep)|(nik&~keep);
+    }
+}
+
+/**
+ * @brief relaxBlock: Floyd-Warshall step of the block (ib,jb) through the servers of block kb
+ * @param stride length of the rows, multiple of floydWarshallBlock
+ */
+void relaxBlock(float *dist,quint8 *next,int n,int stride,int ib,int jb,int kb) {
+    int iEnd=std::min(n,ib+floydWarshallBlock);
+    int kEnd=std::min(n,kb+floydWarshallBlock);
+    for (int k=kb; k<kEnd; k++) {
+        const float *distK=dist+qsizetype(k)*stride;
+        for (int i=ib; i<iEnd; i++) {
+            float *distI=dist+qsizetype(i)*stride;
+            float dik=distI[k];
+            if (i==k || dik==std::numeric_limits<float>::infinity()) continue;
+            quint8 *nextI=next+qsizetype(i)*stride;
+            relaxRow(distI+jb,nextI+jb,distK+jb,dik,nextI[k]);
+        }
+    }
+}
+}
+
+void RoutingTable::buildFloydWarshall(const QList<Server> &servers) {
+    version++;
+    pendingChanges.clear(); // the new table uses the current costs
+    mode = Mode::AllPairs;
+    checkPorts(servers);
+    targetColumns.clear();
+    int n=nServers;
+    // the rows are padded to whole blocks, the padding is never reached
+    int stride=(n+floydWarshallBlock-1)/floydWarshallBlock*floydWarshallBlock;
+    QVector<float> dist(qsizetype(n)*stride,std::numeric_limits<float>::infinity());
+    QVector<quint8> next(qsizetype(n)*stride,quint8(noPort));
+
+    // direct links, the shortest one between two servers
+    for (int i=0; i<n; i++) {
+        const Server &s=servers[i];
+        float *distI=dist.data()+qsizetype(i)*stride;
+        quint8 *nextI=next.data()+qsizetype(i)*stride;
+        distI[i]=0;
+        for (int p=0; p<s.links.size() && p<maxPorts; p++) {
+            Link *l=s.links[p];
+            if (!l->isUsable()) continue;
+            int j=otherServer(l,&s)->id;
+            if (float(l->getDistance())<distI[j]) {
+                distI[j]=float(l->getDistance());
+                nextI[j]=quint8(p);
+            }
+        }
+    }
+
+    // for each block kb: the diagonal block, then the blocks of its row and column,
+    // then all the other blocks, each phase only reads the blocks of the previous ones
+    float *distData=dist.data();
+    quint8 *nextData=next.data();
+    QVector<int> blocks;
+    for (int b=0; b<n; b+=floydWarshallBlock) blocks.push_back(b);
+    for (int kb:blocks) {
+        relaxBlock(distData,nextData,n,stride,kb,kb,kb);
+        QtConcurrent::blockingMap(blocks,[=](int b) {
+            if (b==kb) return;
+            relaxBlock(distData,nextData,n,stride,kb,b,kb);
+            relaxBlock(distData,nextData,n,stride,b,kb,kb);
+        });
+        QtConcurrent::blockingMap(blocks,[=](int ib) {
+            if (ib==kb) return;
+            for (int jb:blocks) {
+                if (jb!=kb) relaxBlock(distData,nextData,n,stride,ib,jb,kb);
+            }
+        });
+    }
+
+    ports.resize(qsizetype(n)*n);
+    distances.resize(qsizetype(n)*n);
+    ports.squeeze();
+    distances.squeeze();
+    for (int i=0; i<n; i++) {
+        const float *distI=distData+qsizetype(i)*stride;
+        std::copy(nextData+qsizetype(i)*stride,nextData+qsizetype(i)*stride+n,ports.data()+qsizetype(i)*n);
+        for (int j=0; j<n; j++) {
+            distances[qsizetype(i)*n+j]=distI[j]<std::numeric_limits<float>::infinity() ? distI[j] : -1.0f;
+        }
+    }
+    buildBackups(servers);
+}
+
+float RoutingTable::getDistance(const QList<Server> &servers,int from,int to) const {
+    if (mode==Mode::TargetTrees) {
+        int column=targetColumns.value(to,-1);
+        return column<0?-1.0f:distances[qsizetype(column)*nServers+from];
+    }
+    if (hasDistances()) return distances[qsizetype(from)*nServers+to];
+    // sum of the links along the next hops
+    float d=0;
+    int cur=from;
+    while (cur!=to) {
+        Link *l=getNextLink(servers[cur],to);
+        if (!l) return -1.0f;
+        d+=l->getDistance();
+        cur=(l->getNode1()->id==cur)?l->getNode2()->id:l->getNode1()->id;
+    }
+    return d;
+}
+
+int RoutingTable::repair(const QList<Server> &servers,const QVector<QPair<Link*,qreal>> &changes) {
+    if (nServers==0 || changes.isEmpty()) return 0;
+    version++;
+    if (mode==Mode::AllPairs && !hasDistances()) {
+        // the distances are needed to find the affected servers
+        QVector<quint8> oldPorts=ports;
+        build(servers,false);
+        int changed=0;
+        for (qsizetype i=0; i<ports.size(); i++) {
+            if (ports[i]!=oldPorts[i]) changed++;
+        }
+        return changed;
+    }
+
+    pendingChanges=changes;
+    nextColumn=0;
+    pendingChanged=0;
+    return finishRepair(servers);
+}
+
+void RoutingTable::repairColumns(const QList<Server> &servers,int count) {
+    // one column for each target: ports[v*n+target] or ports[column*n+v]
+    int nColumns=(mode==Mode::AllPairs) ? nServers : targetColumns.size();
+    int last=qMin(nColumns,nextColumn+count);
+    QVector<Column> columns;
+    quint8 *backupData=hasBackups() ? backupPorts.data() : nullptr;
+    for (int c=nextColumn; c<last; c++) {
+        if (mode==Mode::AllPairs) columns.push_back({ports.data(),distances.data(),backupData,c,nServers});
+        else columns.push_back({ports.data(),distances.data(),backupData,qsizetype(c)*nServers,1});
+    }
+    QVector<int> changedEntries(columns.size(),0);
+    const Server *data=servers.constData();
+    int n=nServers;
+    QVector<int> indices(columns.size());
+    std::iota(indices.begin(),indices.end(),0);
+    int *changedData=changedEntries.data();
+    const Column *columnData=columns.constData();
+    const QVector<QPair<Link*,qreal>> &changes=pendingChanges;
+    QtConcurrent::blockingMap(indices,[=,&changes](int i) {
+        thread_local RepairWorkspace ws;
+        changedData[i]=repairColumn(data,n,columnData[i],changes,ws);
+    });
+    pendingChanged+=std::accumulate(changedEntries.begin(),changedEntries.end(),0);
+    nextColumn=last;
+    if (nextColumn==nColumns) {
+        pendingChanges.clear();
+        version++; // the drones ask again for the routes cached during the repair
+    }
+}
+
+bool RoutingTable::continueRepair(const QList<Server> &servers,qreal budget) {
+    // the first batch gives one column to each thread, the next ones fill half of
+    // the remaining budget from the measured time per column (the columns affected
+    // by the change cost much more than the others), growing at most twice
+    int nThreads=QThreadPool::globalInstance()->maxThreadCount();
+    int batch=nThreads;
+    int nRepaired=0;
+    QElapsedTimer timer;
+    timer.start();
+    while (isRepairing()) {
+        int first=nextColumn;
+        repairColumns(servers,batch);
+        nRepaired+=nextColumn-first;
+        qreal elapsed=timer.nsecsElapsed()*1e-6;
+        if (elapsed>=budget) break;
+        qreal perColumn=elapsed/nRepaired;
+        // below the resolution of the timer, the batch only doubles
+        qreal estimate=(perColumn>0) ? 0.5*(budget-elapsed)/perColumn : 2.0*batch;
+        batch=int(qBound(qreal(nThreads),estimate,2.0*batch));
+    }
+    return !isRepairing();
+}
+
+int RoutingTable::finishRepair(const QList<Server> &servers) {
+    if (!isRepairing()) return 0;
+    repairColumns(servers,std::numeric_limits<int>::max()-nextColumn);
+    return pendingChanged;
+}
+
+int RoutingTable::setLinkDistance(const QList<Server> &servers,Link *link,qreal distance) {
+    finishRepair(servers);
+    qreal old=cost(link);
+    link->setDistance(distance);
+    return repair(servers,{{link,old}});
+}
+
+int RoutingTable::setLinkDistances(const QList<Server> &servers,const QVector<QPair<Link*,qreal>> &distances) {
+    finishRepair(servers);
+    QVector<QPair<Link*,qreal>> changes;
+    for (auto &entry:distances) {
+        changes.push_back({entry.first,cost(entry.first)});
+        entry.first->setDistance(entry.second);
+    }
+    return repair(servers,changes);
+}
+
+void RoutingTable::startLinkDistances(const QList<Server> &servers,const QVector<QPair<Link*,qreal>> &distances) {
+    finishRepair(servers);
+    QVector<QPair<Link*,qreal>> changes;
+    for (auto &entry:distances) {
+        changes.push_back({entry.first,cost(entry.first)});
+        entry.first->setDistance(entry.second);
+    }
+    if (nServers==0 || changes.isEmpty()) return;
+    if (mode==Mode::AllPairs && !hasDistances()) {
+        repair(servers,changes); // rebuilt at once
+        return;
+    }
+    pendingChanges=changes;
+    nextColumn=0;
+    pendingChanged=0;
+}
+
+int RoutingTable::setLinkUp(const QList<Server> &servers,Link *link,bool up) {
+    finishRepair(servers);
+    qreal old=cost(link);
+    link->setUp(up);
+    return repair(servers,{{link,old}});
+}
+
+int RoutingTable::setServerUp(QList<Server> &servers,int id,bool up) {
+    finishRepair(servers);
+    Server &server=servers[id];
+    QVector<QPair<Link*,qreal>> changes;
+    for (Link *l:server.links) changes.push_back({l,cost(l)});
+    server.up=up;
+    return repair(servers,changes);
+}
+
+int RoutingTable::addLink(QList<Server> &servers,Link *link) {
+    finishRepair(servers);
+    link->getNode1()->links.push_back(link);
+    link->getNode2()->links.push_back(link);
+    return repair(servers,{{link,INF}});
+}
@@ -0,0 +1,238 @@
+/**
+ * @brief Shortest paths between the servers through their links.
+ **/
+
+#ifndef ROUTING_H
+#define ROUTING_H
+
+#include <serveranddrone.h>
+#include <QHash>
+
+/**
+ * @brief The Router class: interface of the routing engines read by the drones.
+ */
+class Router {
+public:
+    virtual ~Router() {}
+    /**
+     * @brief getNextLink
+     * @return the next link to follow from server from toward server #to, nullptr if none
+     */
+    virtual Link* getNextLink(const Server &from,int to) const =0;
+    /**
+     * @brief getRoute: the links of the shortest path from server from to server #to,
+     * by default the next links are followed one by one
+     * @return an empty route if server #to is unreachable
+     */
+    virtual QVector<Link*> getRoute(const Server &from,int to) const;
+    /**
+     * @brief getDistance: length of the shortest path from server #from to server #to
+     * @param servers the servers used to build the engine
+     * @return -1 if server #to is unreachable
+     */
+    virtual float getDistance(const QList<Server> &servers,int from,int to) const =0;
+    /**
+     * @brief getBackupLink: alternate to the next link when it or its other server is down,
+     * used by the drones until the router is repaired
+     * @return nullptr if the engine has no alternate (default)
+     */
+    virtual Link* getBackupLink(const Server &,int) const { return nullptr; }
+    /**
+     * @brief getVersion: changed each time the routes may have changed,
+     * the drones keep their cached route while the version is the same
+     */
+    quint32 getVersion() const { return version; }
+protected:
+    quint32 version=0;
+};
+
+/**
+ * @brief The RoutingTable class: next hop from each server toward each other server.
+ *
+ * The next hop is stored as a port, the index of the link in the links list of
+ * the server. Two modes are available:
+ *  - AllPairs: one contiguous row-major block of n² bytes (ports[from*n+to]),
+ *    the distances can also be kept as a float matrix, otherwise they are summed
+ *    along the next hops when they are asked.
+ *  - TargetTrees: only the servers used as targets have a column (ports[column*n+from]),
+ *    filled by a single Dijkstra rooted at the target. Memory and build time are
+ *    O(targets.n), the columns are cached when new targets are added.
+ *
+ * When a link or a server changes, the table is repaired instead of rebuilt:
+ * for each target, only the servers whose next hops lead through an increased
+ * link are reset, then improvements are propagated from them and from the
+ * decreased links by a local Dijkstra. The links that are not usable are
+ * ignored; they stay in the lists of the servers so that the ports are unchanged.
+ *
+ * When the distances are kept, each entry also has a backup port, a loop-free
+ * alternate: the best other neighbour strictly closer to the target (downstream
+ * neighbour), preferably one whose next hop avoids the primary next server.
+ * Each hop, primary or backup, gets strictly closer to the target, so the drones
+ * that switch to the backups never loop, even when several of them fail over.
+ */
+class RoutingTable : public Router {
+public:
+    static const quint8 noPort=0xFF; ///< no next hop: same server or unreachable server
+    static const int maxPorts=0xFF; ///< links of a server that can be used as a next hop
+    enum class Mode { AllPairs, TargetTrees };
+
+    /**
+     * @brief build: all-pairs shortest paths, one Dijkstra per source server.
+     * The sources are shared out among the threads of the global pool, each thread
+     * reuses its own workspace and writes only the rows of its sources.
+     * @param servers the servers (the id of a server is its index) and their links
+     * @param keepDistances also store the n² distances, needed by the backup ports
+     */
+    void build(const QList<Server> &servers,bool keepDistances=true);
+    /**
+     * @brief buildFloydWarshall: all-pairs shortest paths by a blocked Floyd-Warshall,
+     * same table as build (with the distances). The matrices are updated by square
+     * blocks that stay in the cache, the inner loop over a block row is vectorized
+     * by the compiler and the independent blocks are shared out among the threads.
+     * O(n³) but without heap: faster than build for small dense graphs.
+     * @param servers the servers (the id of a server is its index) and their links
+     */
+    void buildFloydWarshall(const QList<Server> &servers);
+    /**
+     * @brief buildTargets: switch to the TargetTrees mode and build the shortest
+     * path trees rooted at the targets that are not cached yet (in parallel).
+     * @param servers the servers (the id of a server is its index) and their links
+     * @param targets ids of the target servers
+     */
+    void buildTargets(const QList<Server> &servers,const QVector<int> &targets);
+    /**
+     * @brief setLinkDistance: change the cost of a link and repair the table
+     * @return the number of next hops that have changed
+     */
+    int setLinkDistance(const QList<Server> &servers,Link *link,qreal distance);
+    /**
+     * @brief setLinkDistances: change the cost of several links and repair the table once
+     * @param distances the links and their new cost
+     * @return the number of next hops that have changed
+     */
+    int setLinkDistances(const QList<Server> &servers,const QVector<QPair<Link*,qreal>> &distances);
+    /**
+     * @brief startLinkDistances: change the cost of several links, the columns of the
+     * table are repaired by the next calls of continueRepair, a few at a time, so that
+     * the simulation is not stalled. Meanwhile each column is either repaired or not
+     * yet: the routes toward a target stay consistent and loop-free.
+     * @param distances the links and their new cost
+     */
+    void startLinkDistances(const QList<Server> &servers,const QVector<QPair<Link*,qreal>> &distances);
+    /**
+     * @brief continueRepair: repair columns of the pending change until the budget is spent
+     * @param budget real time (ms)
+     * @return true when the repair is complete
+     */
+    bool continueRepair(const QList<Server> &servers,qreal budget);
+    /**
+     * @brief finishRepair: repair all the remaining columns of the pending change,
+     * called by the other changes of the table before they modify the links
+     * @return the number of next hops changed by the pending change, 0 if none
+     */
+    int finishRepair(const QList<Server> &servers);
+    bool isRepairing() const { return !pendingChanges.isEmpty(); }
+    /**
+     * @brief setLinkUp: enable or disable a link and repair the table
+     * @return the number of next hops that have changed
+     */
+    int setLinkUp(const QList<Server> &servers,Link *link,bool up);
+    /**
+     * @brief setServerUp: put a server online or offline and repair the table,
+     * an offline server is unreachable and is not used as a relay
+     * @return the number of next hops that have changed
+     */
+    int setServerUp(QList<Server> &servers,int id,bool up);
+    /**
+     * @brief addLink: add a new link to the lists of its two servers and repair the table
+     * @return the number of next hops that have changed
+     */
+    int addLink(QList<Server> &servers,Link *link);
+    /**
+     * @brief clear: forget all the next hops and release their memory, to be called
+     * when the links change
+     */
+    void clear();
+    Mode getMode() const { return mode; }
+    int size() const { return nServers; }
+    bool hasDistances() const { return !distances.isEmpty(); }
+    bool hasBackups() const { return !backupPorts.isEmpty(); }
+    /**
+     * @brief hasTarget
+     * @return true if the next hops toward server #to are known
+     */
+    bool hasTarget(int to) const { return mode==Mode::AllPairs || targetColumns.contains(to); }
+    /**
+     * @brief getPort
+     * @return the index in from.links of the next link toward server #to, noPort if none
+     * (or if server #to is not a target in TargetTrees mode)
+     */
+    quint8 getPort(int from,int to) const {
+        if (mode==Mode::AllPairs) return ports[qsizetype(from)*nServers+to];
+        int column=targetColumns.value(to,-1);
+        return column<0?noPort:ports[qsizetype(column)*nServers+from];
+    }
+    /**
+     * @brief getNextLink
+     * @return the next link to follow from server from toward server #to, nullptr if none
+     */
+    Link* getNextLink(const Server &from,int to) const override {
+        quint8 port=getPort(from.id,to);
+        return port==noPort?nullptr:from.links[port];
+    }
+    /**
+     * @brief getBackupPort
+     * @return the index in from.links of the loop-free alternate toward server #to,
+     * noPort if none (or if the distances are not kept)
+     */
+    quint8 getBackupPort(int from,int to) const {
+        if (backupPorts.isEmpty()) return noPort;
+        if (mode==Mode::AllPairs) return backupPorts[qsizetype(from)*nServers+to];
+        int column=targetColumns.value(to,-1);
+        return column<0?noPort:backupPorts[qsizetype(column)*nServers+from];
+    }
+    Link* getBackupLink(const Server &from,int to) const override {
+        quint8 port=getBackupPort(from.id,to);
+        return port==noPort?nullptr:from.links[port];
+    }
+    /**
+     * @brief getDistance: length of the shortest path from server #from to server #to
+     * @param servers the servers used to build the table, to follow the next hops
+     * when the distances are not kept
+     * @return -1 if server #to is unreachable
+     */
+    float getDistance(const QList<Server> &servers,int from,int to) const override;
+private:
+    /**
+     * @brief checkPorts: set the number of servers and warn if some links cannot be used
+     */
+    void checkPorts(const QList<Server> &servers);
+    /**
+     * @brief buildBackups: backup ports of all the entries in AllPairs mode, from the distances
+     */
+    void buildBackups(const QList<Server> &servers);
+    /**
+     * @brief repair: update the table after a change of the cost of some links.
+     * Without the distances (AllPairs mode), the table is rebuilt.
+     * @param changes the changed links and their previous cost (infinite if they were not usable)
+     * @return the number of next hops that have changed
+     */
+    int repair(const QList<Server> &servers,const QVector<QPair<Link*,qreal>> &changes);
+    /**
+     * @brief repairColumns: repair the columns of the pending change from nextColumn,
+     * at most count of them
+     */
+    void repairColumns(const QList<Server> &servers,int count);
+
+    Mode mode=Mode::AllPairs;
+    int nServers=0;
+    QVector<quint8> ports; ///< next hops, ports[from*nServers+to] or ports[column*nServers+from]
+    QVector<float> distances; ///< distances with the same layout as ports, -1 if unreachable, empty if not kept
+    QVector<quint8> backupPorts; ///< loop-free alternates with the same layout as ports, empty without the distances
+    QHash<int,int> targetColumns; ///< target id -> column, in TargetTrees mode
+    QVector<QPair<Link*,qreal>> pendingChanges; ///< changed links and their previous cost, while some columns are not repaired
+    int nextColumn=0; ///< first column of the pending change that is not repaired
+    int pendingChanged=0; ///< next hops changed by the pending change so far
+};
+
+#endif // ROUTING_H
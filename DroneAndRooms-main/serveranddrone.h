@@ -4,6 +4,7 @@
 #include <QPoint>
 #include <QColor>
 #include <QPainter>
+#include <QAtomicInt>
 #include <polygon.h>
 
 const qreal accelation = 2.0; // unit/s²
@@ -20,12 +21,8 @@ public :
     QPointF position;
     QColor color;
     Polygon area;
-    QList<Link*> links;
-    /** bestDistance: vector of pair(link, distance)
-     *  link is the link to follow from the current server to reach a server destination
-     *  for example bestDistance[0]={link to go to server#0,distance to this server}
-    **/
-    QVector<QPair<Link*,qreal>> bestDistance;
+    QList<Link*> links; ///< the next hops of the routing table are indices in this list
+    bool up=true; ///< an offline server neither receives nor forwards drones
 };
 
 class Link {
@@ -40,37 +37,49 @@ public:
     void draw(QPainter &painter);
     Server* getNode1() { return node1; }
     Server* getNode2() { return node2; }
+    /**
+     * @brief getDistance
+     * @return the cost of the link for the routing, its length when it is not congested
+     */
     qreal getDistance() const { return distance; }
+    /**
+     * @brief setDistance: change the cost of the link (congestion, maintenance),
+     * RoutingTable::setLinkDistance also repairs the routing table
+     */
+    void setDistance(qreal d) { distance=d; }
+    /**
+     * @brief getLength
+     * @return the length of the path between the two servers through the door
+     */
+    qreal getLength() const { return length; }
+    /**
+     * @brief addCrossing: called each time a drone goes through the door,
+     * by the threads that move the drones
+     */
+    void addCrossing() { crossings.fetchAndAddRelaxed(1); }
+    /**
+     * @brief takeCrossings
+     * @return the number of drones that went through the door since the last call
+     */
+    int takeCrossings() { return crossings.fetchAndStoreRelaxed(0); }
+    bool isUp() const { return up; }
+    void setUp(bool state) { up=state; }
+    /**
+     * @brief isUsable
+     * @return true if the link and its two servers are up
+     */
+    bool isUsable() const { return up && node1->up && node2->up; }
     Vector2D getEdgeCenter() { return Vector2D(edgeCenter.x(),edgeCenter.y()); }
+    const QPair<Vector2D,Vector2D> &getEdge() const { return edge; }
 private:
     Server *node1;
     Server *node2;
+    QPair<Vector2D,Vector2D> edge; ///< common edge of the areas of the two servers (door)
     QPointF edgeCenter;
+    qreal length;
     qreal distance;
-};
-
-class Drone {
-public :
-    QString name;
-    Vector2D position;
-    Server *target;
-    qreal azimut=0;
-    Vector2D destination;
-    /**
-     * @brief Moves the drone toward its destination.
-     * @param dt Time step in seconds.
-     *
-     * The drone follows these rules:
-     *  - It moves inside its current server area
-     *  - When reaching a server, it follows the shortest path to the target server
-     *  - Area transitions are done only through edge centers (doors)
-     *  - Speed and orientation are updated smoothly
-     */
-    void move(qreal dt);
-    Server* overflownArea(QList<Server>& list);
-private:
-    Server *connectedTo;
-    Vector2D speed;
+    bool up=true;
+    QAtomicInt crossings; ///< atomic: the counts do not depend on the order of the threads
 };
 
 #endif // SERVERANDDRONE_H
@@ -0,0 +1,118 @@
+#include "shortestpath.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// bit pattern of a non-negative distance, ordered as the distances
+quint64 toKey(qreal d) {
+    quint64 key;
+    std::memcpy(&key,&d,sizeof(key));
+    return key;
+}
+
+qreal fromKey(quint64 key) {
+    qreal d;
+    std::memcpy(&d,&key,sizeof(d));
+    return d;
+}
+
+// index of the highest bit where the key differs from the last popped key, 0 if equal
+int bucketOf(quint64 key,quint64 last) {
+    return key==last ? 0 : 64-int(qCountLeadingZeroBits(key^last));
+}
+}
+
+void RadixHeap::clear() {
+    for (auto &bucket:buckets) bucket.clear();
+    last=0;
+    count=0;
+}
+
+void RadixHeap::push(qreal d,int v) {
+    quint64 key=toKey(d);
+    buckets[bucketOf(key,last)].push_back({key,v});
+    count++;
+}
+
+int RadixHeap::pop(qreal &d) {
+    if (buckets[0].empty()) {
+        // the smallest key of the first non-empty bucket becomes the last key,
+        // the other keys of the bucket go to lower buckets
+        int i=1;
+        while (buckets[i].empty()) i++;
+        last=std::min_element(buckets[i].begin(),buckets[i].end())->first;
+        for (auto &entry:buckets[i]) buckets[bucketOf(entry.first,last)].push_back(entry);
+        buckets[i].clear();
+    }
+    auto entry=buckets[0].back();
+    buckets[0].pop_back();
+    count--;
+    d=fromKey(entry.first);
+    return entry.second;
+}
+
+void ShortestPathTree::push(qreal d,int v) {
+    if (queue==Queue::RadixHeap) {
+        radix.push(d,v);
+    } else {
+        heap.push_back({d,v});
+        std::push_heap(heap.begin(),heap.end(),std::greater<Item>());
+    }
+}
+
+int ShortestPathTree::pop(qreal &d) {
+    if (queue==Queue::RadixHeap) return radix.pop(d);
+    std::pop_heap(heap.begin(),heap.end(),std::greater<Item>());
+    Item top=heap.back();
+    heap.pop_back();
+    d=top.d;
+    return top.v;
+}
+
+bool ShortestPathTree::empty() const {
+    return queue==Queue::RadixHeap ? radix.empty() : heap.empty();
+}
+
+void ShortestPathTree::run(const Server *servers,int nServers,int p_source) {
+    source=p_source;
+    dist.fill(infinity,nServers);
+    parentLink.fill(nullptr,nServers);
+    firstLink.fill(-1,nServers);
+    heap.clear();
+    radix.clear();
+    dist[source]=0;
+
+    // the neighbours of the source start the first links
+    const Server &src=servers[source];
+    for (int p=0; p<src.links.size(); p++) {
+        Link *l=src.links[p];
+        if (!l->isUsable()) continue;
+        int v=(l->getNode1()==&src ? l->getNode2() : l->getNode1())->id;
+        if (l->getDistance()<dist[v]) {
+            dist[v]=l->getDistance();
+            parentLink[v]=l;
+            firstLink[v]=p;
+            push(dist[v],v);
+        }
+    }
+
+    while (!empty()) {
+        qreal d;
+        int u=pop(d);
+        if (d!=dist[u]) continue; // outdated entry
+        const Server *uS=&servers[u];
+        int first=firstLink[u];
+        for (Link *l:uS->links) {
+            if (!l->isUsable()) continue;
+            int v=(l->getNode1()==uS ? l->getNode2() : l->getNode1())->id;
+            qreal nd=d+l->getDistance();
+            if (nd<dist[v]) {
+                dist[v]=nd;
+                parentLink[v]=l;
+                firstLink[v]=first;
+                push(nd,v);
+            }
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * @brief Shortest path tree from one server, the Dijkstra kernel shared by
+ * the routing engines.
+ **/
+
+#ifndef SHORTESTPATH_H
+#define SHORTESTPATH_H
+
+#include <serveranddrone.h>
+#include <vector>
+#include <limits>
+
+/**
+ * @brief The RadixHeap class: monotone priority queue of servers for Dijkstra.
+ *
+ * The distances are non-negative doubles, their bit patterns are ordered as the
+ * distances. A key is stored in the bucket of the highest bit where it differs
+ * from the last popped key, the keys of a bucket are only redistributed when
+ * it becomes the first one: each key moves at most 64 times, with no comparison
+ * between keys. The pushed keys must not be smaller than the last popped key.
+ */
+class RadixHeap {
+public:
+    void clear();
+    bool empty() const { return count==0; }
+    void push(qreal d,int v);
+    /**
+     * @brief pop: remove a server of smallest key
+     * @param d set to the key of the server
+     * @return the server
+     */
+    int pop(qreal &d);
+private:
+    static const int nBuckets=65;
+    std::vector<std::pair<quint64,int>> buckets[nBuckets];
+    quint64 last=0;
+    size_t count=0;
+};
+
+/**
+ * @brief The ShortestPathTree class: Dijkstra from one source server through
+ * the usable links.
+ *
+ * The arrays and the queue are kept from one run to the next one: a thread
+ * that reuses its tree does not allocate after the first run. The first link
+ * of the path to each server is carried forward when a link is relaxed, so
+ * the next hops of the source are known without backtracking the parents.
+ */
+class ShortestPathTree {
+public:
+    enum class Queue {
+        BinaryHeap, ///< std::push_heap/std::pop_heap on a vector, lazy deletion
+        RadixHeap ///< RadixHeap: integer operations on the bits of the distances
+    };
+    explicit ShortestPathTree(Queue queue=Queue::BinaryHeap):queue(queue) {}
+    void setQueue(Queue q) { queue=q; }
+    /**
+     * @brief run: shortest paths from server #source to all the servers
+     * @param servers the servers (the id of a server is its index) and their links
+     * @param nServers number of servers
+     */
+    void run(const Server *servers,int nServers,int source);
+    int getSource() const { return source; }
+    bool isReached(int v) const { return dist[v]<infinity; }
+    /**
+     * @brief getDistance
+     * @return the length of the shortest path from the source to server #v, infinite if unreachable
+     */
+    qreal getDistance(int v) const { return dist[v]; }
+    /**
+     * @brief getParentLink
+     * @return the last link of the shortest path to server #v, nullptr for the source or if unreachable
+     */
+    Link* getParentLink(int v) const { return parentLink[v]; }
+    /**
+     * @brief getFirstLinkIndex
+     * @return the index in the links of the source of the first link of the shortest
+     * path to server #v, -1 for the source or if unreachable
+     */
+    int getFirstLinkIndex(int v) const { return firstLink[v]; }
+
+    static constexpr qreal infinity=std::numeric_limits<qreal>::infinity();
+private:
+    struct Item {
+        qreal d;
+        int v;
+        bool operator>(const Item& o) const { return d > o.d; }
+    };
+    void push(qreal d,int v);
+    int pop(qreal &d);
+    bool empty() const;
+
+    Queue queue;
+    int source=-1;
+    QVector<qreal> dist;
+    QVector<Link*> parentLink;
+    QVector<int> firstLink;
+    std::vector<Item> heap;
+    RadixHeap radix;
+};
+
+#endif // SHORTESTPATH_H
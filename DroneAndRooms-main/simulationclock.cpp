@@ -0,0 +1,52 @@
+#include "simulationclock.h"
+#include <QtGlobal>
+#include <cmath>
+
+void SimulationClock::start() {
+    time=0;
+    accumulator=0;
+    dropped=0;
+    started=true;
+    paused=false;
+    realTime.start();
+    last=0;
+}
+
+void SimulationClock::stop() {
+    time=0;
+    accumulator=0;
+    dropped=0;
+    started=false;
+    paused=false;
+}
+
+void SimulationClock::pause() {
+    paused=true;
+}
+
+void SimulationClock::resume() {
+    if (!paused) return;
+    paused=false;
+    // the time spent in pause is not simulated
+    last=realTime.nsecsElapsed();
+}
+
+void SimulationClock::setSpeed(qreal s) {
+    speed=qBound(minSpeed,s,maxSpeed);
+}
+
+int SimulationClock::advance(int maxSteps) {
+    if (!started || paused) return 0;
+    qint64 now=realTime.nsecsElapsed();
+    accumulator+=(now-last)*1e-9*speed;
+    last=now;
+    qreal n=std::floor(accumulator/step);
+    if (n>maxSteps) {
+        dropped+=(n-maxSteps)*step;
+        accumulator-=(n-maxSteps)*step;
+        n=maxSteps;
+    }
+    accumulator-=n*step;
+    time+=n*step;
+    return int(n);
+}
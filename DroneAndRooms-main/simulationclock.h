@@ -0,0 +1,76 @@
+/**
+ * @brief Simulated time of the drones, advanced by fixed steps from the real time.
+ **/
+
+#ifndef SIMULATIONCLOCK_H
+#define SIMULATIONCLOCK_H
+
+#include <QElapsedTimer>
+
+/**
+ * @brief The SimulationClock class: fixed time step simulation with a speed multiplier.
+ *
+ * The real time elapsed since the last call of advance, multiplied by the
+ * speed, is added to an accumulator, that gives the number of whole steps to
+ * simulate; the remainder is kept for the next call. The simulation always
+ * advances by the same step whatever the frame rate or the speed, and the
+ * time spent in pause is not counted.
+ */
+class SimulationClock {
+public:
+    static constexpr qreal minSpeed=0.1;
+    static constexpr qreal maxSpeed=10000;
+
+    /**
+     * @brief SimulationClock
+     * @param step simulated time of one step (s)
+     */
+    explicit SimulationClock(qreal step=0.05):step(step) {}
+    /**
+     * @brief start: simulated time set to 0, the clock runs
+     */
+    void start();
+    /**
+     * @brief stop: the clock is not started any more, start must be called again
+     */
+    void stop();
+    void pause();
+    void resume();
+    bool isStarted() const { return started; }
+    bool isPaused() const { return paused; }
+    /**
+     * @brief setSpeed: simulated seconds per real second, clamped to [minSpeed,maxSpeed]
+     */
+    void setSpeed(qreal s);
+    qreal getSpeed() const { return speed; }
+    qreal getStep() const { return step; }
+    /**
+     * @brief getTime
+     * @return simulated time since start (s)
+     */
+    qreal getTime() const { return time; }
+    /**
+     * @brief getDroppedTime
+     * @return simulated time skipped because the steps were too slow to follow the speed (s)
+     */
+    qreal getDroppedTime() const { return dropped; }
+    /**
+     * @brief advance: adds the elapsed real time to the accumulator
+     * @param maxSteps at most maxSteps steps are returned, the simulated time of
+     * the other ones is dropped (the simulation is late, the accumulator must not grow)
+     * @return the number of steps to simulate now, 0 when paused
+     */
+    int advance(int maxSteps);
+private:
+    qreal step;
+    qreal speed=1.0;
+    qreal time=0;
+    qreal accumulator=0;
+    qreal dropped=0;
+    bool started=false;
+    bool paused=false;
+    QElapsedTimer realTime;
+    qint64 last=0; ///< real time of the last call of advance (ns)
+};
+
+#endif // SIMULATIONCLOCK_H
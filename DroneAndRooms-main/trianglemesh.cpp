@@ -5,134 +5,338 @@ TriangleMesh::TriangleMesh(QList<Server> &servers) {
     for (auto &s:servers) {
         tabVertices.push_back(Vector2D(s.position.x(),s.position.y()));
     }
-    // create the convex hull
-    Polygon convexHull(tabVertices);
+    vertexTriangle.fill(-1,tabVertices.size());
+    // vertices of the convex hull, the vertices placed on the middle of a
+    // hull edge are inserted later as the internal vertices
+    QVector<int> hullVertices=Polygon::convexHull(tabVertices);
+    if (hullVertices.size()<3) return; // aligned vertices: no triangle
+    QVector<bool> isHullVertex(tabVertices.size(),false);
+    for (int v:hullVertices) {
+        isHullVertex[v]=true;
+    }
+    triangulateConvexPolygon(hullVertices);
 
-    tabTriangles=convexHull.getTriangles();
-    // list of server that are not in the convexhull
-    QList<Vector2D> internalVertices;
-    for (auto &s:servers) {
-        Vector2D p(Vector2D(s.position.x(),s.position.y()));
-        if (!convexHull.isAVertex(p)) {
-            internalVertices.append(p);
+    // Bowyer-Watson: each insertion of a server that is not in the convex hull
+    // keeps the mesh Delaunay
+    for (int v=0; v<tabVertices.size(); v++) {
+        if (!isHullVertex[v]) {
+            insertVertex(v);
         }
     }
+}
 
-    for (auto &vertex:internalVertices) {
-        auto tri=tabTriangles.begin();
-        while (tri!=tabTriangles.end() && !tri->contains(&vertex)) tri++;
-        if (tri!=tabTriangles.end()) {
-            Vector2D v0 = (*tri)[0];
-            Vector2D v1 = (*tri)[1];
-            Vector2D v2 = (*tri)[2];
-            tri->update(v0,v1,vertex);
-            tabTriangles.push_back(Triangle(v1,v2,vertex));
-            tabTriangles.push_back(Triangle(v2,v0,vertex));
+void TriangleMesh::triangulateConvexPolygon(const QVector<int> &vertices) {
+    if (vertices.size()<3) return;
+    // stack of sub-polygons [i..j] closed by the edge (P_j,P_i) of a parent triangle
+    struct Range { int i,j,parent; };
+    QStack<Range> ranges;
+    ranges.push({0,int(vertices.size())-1,-1});
+    while (!ranges.empty()) {
+        Range range=ranges.pop();
+        int i=range.i, j=range.j;
+        if (j-i<2) continue;
+        const Vector2D &Pi=tabVertices[vertices[i]];
+        const Vector2D &Pj=tabVertices[vertices[j]];
+        // the Delaunay triangle of edge (P_j,P_i) is the one whose circumcircle
+        // contains no other vertex of the sub-polygon
+        int k=i+1;
+        for (int m=i+2; m<j; m++) {
+            if (incircle(Pi,tabVertices[vertices[k]],Pj,tabVertices[vertices[m]])>0) k=m;
         }
+        int t=tabTriangles.size();
+        setTriangle(t,vertices[i],vertices[k],vertices[j]);
+        if (range.parent!=-1) {
+            tabTriangles[t].neighbour[2]=range.parent;
+            setNeighbour(range.parent,vertices[i],t);
+        }
+        ranges.push({i,k,t});
+        ranges.push({k,j,t});
+    }
+}
+
+void TriangleMesh::insertVertex(int v) {
+    const Vector2D &vertex=tabVertices[v];
+    // search the triangle containing the new vertex
+    int seed=locate(vertex);
+    if (seed==-1) return;
+    for (int i=0; i<3; i++) {
+        if (tabVertices[tabTriangles[seed].vertex[i]]==vertex) return; // duplicated position
     }
 
-    while (!checkDelaunay()) {
-        // search the first triangle that is not delaunay compliant and flippabe
-        auto it = tabTriangles.begin();
-        while (it!=tabTriangles.end() && !(*it).canBeFlipped()) {
-            it++;
+    // edge (v0,v1) of the border of the cavity, outside is the triangle on the other side
+    struct BorderEdge { int v0,v1,outside; };
+    QVector<int> cavity,excluded,forced;
+    QVector<BorderEdge> border;
+    bool isStarShaped;
+    do {
+        // the cavity is the connected set of triangles around the seed triangle
+        // whose circumcircle strictly contains the vertex
+        currentMark++;
+        cavity.clear();
+        cavity.push_back(seed);
+        tabMarks[seed]=currentMark;
+        for (int c=0; c<cavity.size(); c++) {
+            for (int i=0; i<3; i++) {
+                int n=tabTriangles[cavity[c]].neighbour[i];
+                if (n==-1 || tabMarks[n]==currentMark || excluded.contains(n)) continue;
+                if (forced.contains(n) || isInCircle(n,vertex)) {
+                    tabMarks[n]=currentMark;
+                    cavity.push_back(n);
+                }
+            }
+        }
+
+        // the cavity must be star-shaped from the new vertex:
+        // remove the triangles which hide one of their border edges
+        isStarShaped=true;
+        border.clear();
+        for (int c=0; c<cavity.size() && isStarShaped; c++) {
+            const MeshTriangle &tri=tabTriangles[cavity[c]];
+            for (int i=0; i<3 && isStarShaped; i++) {
+                int n=tri.neighbour[i];
+                if (n!=-1 && tabMarks[n]==currentMark) continue; // internal edge of the cavity
+
+                int a=tri.vertex[i], b=tri.vertex[(i+1)%3];
+                const Vector2D &A=tabVertices[a], &B=tabVertices[b];
+                double side=orient2d(A,B,vertex);
+                if (side>0) {
+                    border.push_back({a,b,n});
+                } else if (side==0 && cavity[c]==seed) {
+                    // the vertex is on an edge of the seed triangle:
+                    // the neighbour triangle (if any) must be in the cavity
+                    if (n!=-1) {
+                        forced.push_back(n);
+                        isStarShaped=false;
+                    }
+                } else {
+                    excluded.push_back(cavity[c]);
+                    isStarShaped=false;
+                }
+            }
+        }
+    } while (!isStarShaped);
+
+    // replace the cavity by the fan of triangles joining the vertex to the border
+    QVector<int> fan;
+    for (int e=0; e<border.size(); e++) {
+        int t=(e<cavity.size())?cavity[e]:tabTriangles.size();
+        setTriangle(t,border[e].v0,border[e].v1,v);
+        tabTriangles[t].neighbour[0]=border[e].outside;
+        if (border[e].outside!=-1) {
+            setNeighbour(border[e].outside,border[e].v1,t);
+        }
+        fan.push_back(t);
+    }
+    // link the triangles of the fan together
+    for (int e=0; e<border.size(); e++) {
+        for (int f=0; f<border.size(); f++) {
+            if (border[f].v0==border[e].v1) tabTriangles[fan[e]].neighbour[1]=fan[f];
+            if (border[f].v1==border[e].v0) tabTriangles[fan[e]].neighbour[2]=fan[f];
         }
-        if (it!=tabTriangles.end()) {
-            flipTriangle(&(*it));
+    }
+    // remove unused slots (from the greatest index to keep the others valid)
+    QVector<int> unused=cavity.mid(qMin(cavity.size(),border.size()));
+    std::sort(unused.begin(),unused.end());
+    for (int c=unused.size()-1; c>=0; c--) {
+        int last=tabTriangles.size()-1;
+        removeTriangle(unused[c]);
+        // the last triangle moved to the removed slot
+        for (int &t:fan) {
+            if (t==last) t=unused[c];
         }
     }
 
+    // the border edges of a cavity reduced to be star-shaped may not be Delaunay:
+    // legalize them, the flips only check the edges around them
+    QStack<QPair<int,int>> edges;
+    for (int t:fan) {
+        if (tabTriangles[t].neighbour[0]!=-1) edges.push({t,0});
+    }
+    legalize(edges,3*tabTriangles.size());
+}
+
+int TriangleMesh::legalize(QStack<QPair<int,int>> &edges,int maxFlips) {
+    int nFlips=0;
+    while (!edges.empty() && nFlips<maxFlips) {
+        auto edge=edges.pop();
+        int t=edge.first, i=edge.second;
+        int n=tabTriangles[t].neighbour[i];
+        if (n==-1) continue;
+        int a=tabTriangles[t].vertex[i];
+        int b=tabTriangles[t].vertex[(i+1)%3];
+        int c=tabTriangles[t].vertex[(i+2)%3];
+        int j=0;
+        while (j<3 && tabTriangles[n].vertex[j]!=b) j++;
+        int d=tabTriangles[n].vertex[(j+2)%3];
+        // incircle test against the single opposite vertex, the flipped
+        // triangles must stay CCW
+        const Vector2D &A=tabVertices[a], &B=tabVertices[b], &C=tabVertices[c], &D=tabVertices[d];
+        if (!isInCircle(t,D) || orient2d(C,A,D)<=0 || orient2d(D,B,C)<=0) continue;
+        flipEdge(t,i);
+        nFlips++;
+        // (c,a,d) and (d,b,c): check the 4 edges of the quadrilateral
+        edges.push({t,0});
+        edges.push({t,1});
+        edges.push({n,0});
+        edges.push({n,1});
+    }
+    if (!edges.empty()) {
+        qWarning() << "TriangleMesh::legalize: stopped after" << nFlips << "flips";
+    }
+    return nFlips;
 }
 
-bool TriangleMesh::checkDelaunay() {
-    bool areAllDelaunay=true;
-    for (auto &tri:tabTriangles) {
-        bool res = tri.checkDelaunay(tabVertices);
-        if (!res) {
-            auto L=findOppositPointOfTrianglesWithCommonEdge(tri);
-            auto it=L.begin();
-            while (it!=L.end() && tri.circleContains(*it)) {
-                it++;
-            }
-            tri.setDelaunay(false,it!=L.end());
+void TriangleMesh::flipEdge(int t,int i) {
+    int n=tabTriangles[t].neighbour[i];
+    int a=tabTriangles[t].vertex[i];
+    int b=tabTriangles[t].vertex[(i+1)%3];
+    int c=tabTriangles[t].vertex[(i+2)%3];
+    int nBC=tabTriangles[t].neighbour[(i+1)%3];
+    int nCA=tabTriangles[t].neighbour[(i+2)%3];
+    int j=0;
+    while (j<3 && tabTriangles[n].vertex[j]!=b) j++;
+    int d=tabTriangles[n].vertex[(j+2)%3];
+    int nAD=tabTriangles[n].neighbour[(j+1)%3];
+    int nDB=tabTriangles[n].neighbour[(j+2)%3];
+
+    setTriangle(t,c,a,d);
+    tabTriangles[t].neighbour[0]=nCA;
+    tabTriangles[t].neighbour[1]=nAD;
+    tabTriangles[t].neighbour[2]=n;
+    setTriangle(n,d,b,c);
+    tabTriangles[n].neighbour[0]=nDB;
+    tabTriangles[n].neighbour[1]=nBC;
+    tabTriangles[n].neighbour[2]=t;
+    // the outer triangles of the edges (a,d) and (b,c) changed of side
+    if (nAD!=-1) setNeighbour(nAD,d,t);
+    if (nBC!=-1) setNeighbour(nBC,c,n);
+}
+
+int TriangleMesh::locate(const Vector2D &pt) {
+    int T=tabTriangles.size();
+    if (T==0) return -1;
+    // jump: choose the closest triangle among the last located one and
+    // about T^(1/3) random triangles
+    int start=(lastLocated<T)?lastLocated:0;
+    double bestDist=tabVertices[tabTriangles[start].vertex[0]].distance2(pt);
+    int nSamples=int(cbrt(double(T)));
+    for (int i=0; i<nSamples; i++) {
+        sampleSeed=sampleSeed*1103515245u+12345u;
+        int t=(sampleSeed>>8)%T;
+        double d=tabVertices[tabTriangles[t].vertex[0]].distance2(pt);
+        if (d<bestDist) {
+            bestDist=d;
+            start=t;
         }
-        areAllDelaunay=areAllDelaunay && res;
     }
-    return areAllDelaunay;
+    // walk
+    int res=walk(start,pt);
+    if (res!=-1) lastLocated=res;
+    return res;
 }
 
-void TriangleMesh::flipTriangle(Triangle *ptrTriangleClicked) {
-    // get the list of opposit points (0..3)
-    auto L=findOppositPointOfTrianglesWithCommonEdge(*ptrTriangleClicked);
-    // search the point that is inside the circumcircle
-    auto it=L.begin();
-    while (it!=L.end() && ptrTriangleClicked->circleContains(*it)) {
-        it++;
-    }
-    // if it exists
-    if (it!=L.end()) {
-        // search the opposit triangle and the ordered list of 4 points
-        auto res = findOppositTriangle(ptrTriangleClicked,*it);
-        // switch the vertices
-        ptrTriangleClicked->update(res.second[0],res.second[1],res.second[3]);
-        res.first->update(res.second[1],res.second[2],res.second[3]);
+int TriangleMesh::walk(int start,const Vector2D &pt) {
+    int t=start;
+    int nSteps=0;
+    int T=tabTriangles.size();
+    while (nSteps++<T) {
+        const MeshTriangle &tri=tabTriangles[t];
+        // cross the first edge that hides pt, starting by a varying edge
+        // so that the walk cannot cycle
+        int first=nSteps%3;
+        int k=0, i=first;
+        while (k<3 && orient2d(tabVertices[tri.vertex[i]],tabVertices[tri.vertex[(i+1)%3]],pt)>=0) {
+            k++;
+            i=(first+k)%3;
+        }
+        if (k==3) return t;
+        if (tri.neighbour[i]==-1) return -1; // crossing the convex hull
+        t=tri.neighbour[i];
     }
+    // the walk failed (degenerated configuration): linear search
+    t=0;
+    while (t<T && !contains(t,pt)) t++;
+    return (t<T)?t:-1;
 }
 
-QPair<Triangle*,Vector2D[4]> TriangleMesh::findOppositTriangle(Triangle *tri, Vector2D oppVertex) {
-    QPair<Triangle*,Vector2D[4]> res;
-
-    // search a triangle with (P0 oppVertex P1) vertices
-    auto it=tabTriangles.begin();
-    Triangle ref((*tri)[0],oppVertex,(*tri)[1]);
-    while (it!=tabTriangles.end() && !((*it)==ref)) {
-        it++;
-    }
-    if (it!=tabTriangles.end()) {
-        res.first = &(*it);
-        res.second[0]=(*tri)[0];
-        res.second[1]=oppVertex;
-        res.second[2]=(*tri)[1];
-        res.second[3]=(*tri)[2];
-        return res;
-    }
-    // search a triangle with (P1 oppVertex P2) vertices
-    it=tabTriangles.begin();
-    ref = Triangle((*tri)[1],oppVertex,(*tri)[2]);
-    while (it!=tabTriangles.end() && !((*it)==ref)) {
-        it++;
-    }
-    if (it!=tabTriangles.end()) {
-        res.first = &(*it);
-        res.second[0]=(*tri)[1];
-        res.second[1]=oppVertex;
-        res.second[2]=(*tri)[2];
-        res.second[3]=(*tri)[0];
-        return res;
-    }
-    // search a triangle with (P2 oppVertex P0) vertices
-    it=tabTriangles.begin();
-    ref = Triangle((*tri)[2],oppVertex,(*tri)[0]);
-    while (it!=tabTriangles.end() && !((*it)==ref)) {
-        it++;
-    }
-    if (it!=tabTriangles.end()) {
-        res.first = &(*it);
-        res.second[0]=(*tri)[2];
-        res.second[1]=oppVertex;
-        res.second[2]=(*tri)[0];
-        res.second[3]=(*tri)[1];
-        return res;
+QVector<Triangle> TriangleMesh::getTriangles() const {
+    QVector<Triangle> triangles;
+    triangles.reserve(tabTriangles.size());
+    for (auto &tri:tabTriangles) {
+        triangles.push_back(Triangle(tabVertices[tri.vertex[0]],tabVertices[tri.vertex[1]],tabVertices[tri.vertex[2]]));
     }
-    return res;
+    return triangles;
 }
 
-QVector<Vector2D> TriangleMesh::findOppositPointOfTrianglesWithCommonEdge(const Triangle &tri) {
-    QVector<Vector2D> res;
-    for (auto &t:tabTriangles) {
-        if (tri.hasEdge(t[1],t[0])) res.push_back(t[2]);
-        else if (tri.hasEdge(t[2],t[1])) res.push_back(t[0]);
-        else if (tri.hasEdge(t[0],t[2])) res.push_back(t[1]);
+QVector<int> TriangleMesh::getFan(int v) const {
+    QVector<int> fan;
+    int t0=vertexTriangle[v];
+    if (t0==-1) return fan;
+    // position of v in triangle #t: edge #k leaves v, edge #(k+2)%3 comes to v
+    auto indexOf=[this,v](int t) {
+        int k=0;
+        while (tabTriangles[t].vertex[k]!=v) k++;
+        return k;
+    };
+    // turn CW until the hull edge leaving v, or a complete turn for an inner vertex
+    int first=t0;
+    int n=tabTriangles[first].neighbour[indexOf(first)];
+    while (n!=-1 && n!=t0) {
+        first=n;
+        n=tabTriangles[first].neighbour[indexOf(first)];
     }
-    return res;
+    if (n==t0) first=t0;
+    // then CCW
+    int t=first;
+    do {
+        fan.push_back(t);
+        t=tabTriangles[t].neighbour[(indexOf(t)+2)%3];
+    } while (t!=-1 && t!=first);
+    return fan;
+}
+
+bool TriangleMesh::isInCircle(int t,const Vector2D &pt) const {
+    const MeshTriangle &tri=tabTriangles[t];
+    return incircle(tabVertices[tri.vertex[0]],tabVertices[tri.vertex[1]],tabVertices[tri.vertex[2]],pt)>0;
+}
+
+bool TriangleMesh::contains(int t,const Vector2D &pt) const {
+    const MeshTriangle &tri=tabTriangles[t];
+    for (int i=0; i<3; i++) {
+        if (orient2d(tabVertices[tri.vertex[i]],tabVertices[tri.vertex[(i+1)%3]],pt)<0) return false;
+    }
+    return true;
+}
+
+void TriangleMesh::setTriangle(int t,int v0,int v1,int v2) {
+    if (t==tabTriangles.size()) {
+        tabTriangles.push_back({{v0,v1,v2},{-1,-1,-1}});
+        tabMarks.push_back(0);
+    } else {
+        tabTriangles[t]={{v0,v1,v2},{-1,-1,-1}};
+    }
+    vertexTriangle[v0]=vertexTriangle[v1]=vertexTriangle[v2]=t;
+}
+
+void TriangleMesh::removeTriangle(int t) {
+    int last=tabTriangles.size()-1;
+    if (t!=last) {
+        tabTriangles[t]=tabTriangles[last];
+        // the neighbours and the vertices of the moved triangle must point to its new index
+        const MeshTriangle &moved=tabTriangles[t];
+        for (int i=0; i<3; i++) {
+            if (moved.neighbour[i]!=-1) {
+                setNeighbour(moved.neighbour[i],moved.vertex[(i+1)%3],t);
+            }
+            if (vertexTriangle[moved.vertex[i]]==last) vertexTriangle[moved.vertex[i]]=t;
+        }
+    }
+    tabTriangles.removeLast();
+    tabMarks.removeLast();
+}
+
+void TriangleMesh::setNeighbour(int t,int v0,int n) {
+    MeshTriangle &tri=tabTriangles[t];
+    int i=(tri.vertex[0]==v0)?0:(tri.vertex[1]==v0)?1:2;
+    tri.neighbour[i]=n;
 }
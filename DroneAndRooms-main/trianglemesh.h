@@ -3,12 +3,59 @@
 
 #include <serveranddrone.h>
 #include <polygon.h>
+#include <QStack>
+
+/**
+ * @brief The MeshTriangle struct: index-based topology of a triangle of the mesh.
+ * Edge #i is the edge (vertex[i],vertex[i+1]), as in Triangle::isOnTheLeft.
+ */
+struct MeshTriangle {
+    int vertex[3]; ///< indices of the vertices in tabVertices (CCW)
+    int neighbour[3]; ///< index of the triangle on the other side of edge #i, -1 on the convex hull
+};
 
 class TriangleMesh {
 public:
     TriangleMesh(QList<Server> &servers);
     void setBox(const QPoint &origin,const QSize &size) { winX0=origin.x(); winY0=origin.y(); winX1=origin.x()+size.width(); winY1=origin.y()+size.height(); }
-    QVector<Triangle>* getTriangles() { return &tabTriangles; }
+    /**
+     * @brief getTriangles
+     * @return a copy of the triangles of the mesh with their coordinates
+     */
+    QVector<Triangle> getTriangles() const;
+    int getNbTriangles() const { return tabTriangles.size(); }
+    int getNbVertices() const { return tabVertices.size(); }
+    const Vector2D &getVertex(int v) const { return tabVertices[v]; }
+    /**
+     * @brief getNeighbour
+     * @param t index of a triangle
+     * @param edge number of the edge (P_iP_{i+1}) in the triangle
+     * @return the index of the triangle sharing this edge, -1 for an edge of the convex hull
+     */
+    int getNeighbour(int t,int edge) const { return tabTriangles[t].neighbour[edge]; }
+    /**
+     * @brief getVertexId
+     * @param t index of a triangle
+     * @param i number of the vertex in the triangle
+     * @return the index of the vertex, which is also the index of its server
+     */
+    int getVertexId(int t,int i) const { return tabTriangles[t].vertex[i]; }
+    /**
+     * @brief getFan: triangles around a vertex, in O(degree)
+     * @param v index of a vertex
+     * @return the triangles containing v in CCW order around v. For a vertex of
+     * the convex hull, the first triangle owns the hull edge leaving v and the last
+     * one owns the hull edge coming to v. Empty if v is not in the mesh (duplicate position).
+     */
+    QVector<int> getFan(int v) const;
+    /**
+     * @brief locate: jump-and-walk point location.
+     * The walk starts from the closest of a small sample of triangles (including
+     * the last located one) and crosses the edges that hide the point.
+     * @param pt the searched point
+     * @return the index of the triangle containing pt, -1 if pt is outside of the convex hull
+     */
+    int locate(const Vector2D &pt);
     bool isInWindow(int x,int y) const { return (x>winX0 && x<winX1 && y>winY0 && y<winY1); }
     bool isInWindow(const Vector2D pos) const { return (pos.x>winX0 && pos.x<winX1 && pos.y>winY0 && pos.y<winY1); }
     int getWindowXmin() const { return winX0; }
@@ -16,14 +63,70 @@ public:
     int getWindowXmax() const { return winX1; }
     int getWindowYmax() const { return winY1; }
 private:
-    bool checkDelaunay();
-    QVector<Vector2D> findOppositPointOfTrianglesWithCommonEdge(const Triangle &tri);
-    QPair<Triangle*,Vector2D[4]> findOppositTriangle(Triangle *tri, Vector2D oppVertex);
-    void flipTriangle(Triangle *);
+    /**
+     * @brief triangulateConvexPolygon: Delaunay triangulation of a convex polygon.
+     * Each edge is closed by the vertex that gives an empty circumcircle.
+     * @param vertices indices of the CCW vertices of the polygon
+     */
+    void triangulateConvexPolygon(const QVector<int> &vertices);
+    /**
+     * @brief insertVertex: Bowyer-Watson insertion of a vertex in the Delaunay mesh.
+     * The triangles whose circumcircle contains the vertex (the cavity) are
+     * replaced by a fan of triangles joining the vertex to the cavity border,
+     * whose edges are then legalized.
+     * @param v index of the new vertex, it must be inside the convex hull
+     */
+    void insertVertex(int v);
+    /**
+     * @brief legalize: Lawson flips driven by a stack of edges to check.
+     * An edge is flipped when the opposite vertex of the neighbour triangle is
+     * inside the circumcircle, and the 4 edges around the flipped edge are then checked.
+     * @param edges edges (v0,v1) to check, each one given by the triangle that owns it
+     * @param maxFlips guard against endless flips in degenerated configurations
+     * @return the number of flips
+     */
+    int legalize(QStack<QPair<int,int>> &edges,int maxFlips);
+    /**
+     * @brief flipEdge: flip the edge #i of triangle #t with the neighbour triangle.
+     * Triangles (a,b,c) and (b,a,d) become (c,a,d) and (d,b,c).
+     */
+    void flipEdge(int t,int i);
+    /**
+     * @brief walk: visibility walk from triangle #start toward pt
+     * @return the index of the triangle containing pt, -1 if pt is outside of the convex hull
+     */
+    int walk(int start,const Vector2D &pt);
+    /**
+     * @brief isInCircle
+     * @return true if pt is strictly inside the circumcircle of triangle #t
+     */
+    bool isInCircle(int t,const Vector2D &pt) const;
+    /**
+     * @brief contains
+     * @return true if pt is inside triangle #t or on its border
+     */
+    bool contains(int t,const Vector2D &pt) const;
+    /**
+     * @brief setTriangle: set the vertices of triangle #t (appended if t is the size of the mesh)
+     * The neighbours must be updated by the caller.
+     */
+    void setTriangle(int t,int v0,int v1,int v2);
+    /**
+     * @brief removeTriangle: remove triangle #t, the last triangle is moved to this place
+     */
+    void removeTriangle(int t);
+    /**
+     * @brief setNeighbour: set the triangle on the other side of edge (v0,v1) of triangle #t
+     */
+    void setNeighbour(int t,int v0,int n);
 
     QVector<Vector2D> tabVertices;
-    QVector<Triangle> tabTriangles;
-    Polygon* convexHull=nullptr;
+    QVector<MeshTriangle> tabTriangles;
+    QVector<int> vertexTriangle; ///< one triangle containing each vertex, -1 if the vertex is not in the mesh
+    QVector<int> tabMarks; ///< marks of the triangles visited by the current search
+    int currentMark=0;
+    int lastLocated=0; ///< triangle found by the last call to locate
+    unsigned int sampleSeed=1; ///< state of the generator used to sample the starting triangles
     int winX0,winX1,winY0,winY1;
 };
 
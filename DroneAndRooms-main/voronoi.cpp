@@ -0,0 +1,320 @@
+#include "voronoi.h"
+#include <QtConcurrent>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+/// point in double precision, the circumcenters of flat triangles can be very far
+struct Point {
+    double x,y;
+};
+
+/**
+ * @brief clipHalfPlane: Sutherland-Hodgman clipping of a convex polygon,
+ * keeps the part where a*x+b*y<=c
+ */
+QVector<Point> clipHalfPlane(const QVector<Point> &poly,double a,double b,double c) {
+    QVector<Point> result;
+    int n=poly.size();
+    for (int i=0; i<n; i++) {
+        const Point &p=poly[i];
+        const Point &q=poly[(i+1)%n];
+        double dp=a*p.x+b*p.y-c;
+        double dq=a*q.x+b*q.y-c;
+        if (dp<=0) result.push_back(p);
+        if ((dp<0 && dq>0) || (dp>0 && dq<0)) {
+            double k=dp/(dp-dq);
+            result.push_back({p.x+k*(q.x-p.x),p.y+k*(q.y-p.y)});
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief clipLine: Liang-Barsky clipping of the line P+s.D to the window
+ * @param s0,s1 range of s, reduced to the part inside the window
+ * @return false if no part of the line is in the window
+ */
+bool clipLine(const Point &P,const Point &D,double &s0,double &s1,double x0,double y0,double x1,double y1) {
+    const double p[4]={-D.x,D.x,-D.y,D.y};
+    const double q[4]={P.x-x0,x1-P.x,P.y-y0,y1-P.y};
+    for (int k=0; k<4; k++) {
+        if (p[k]==0) {
+            if (q[k]<0) return false; // parallel and outside
+        } else {
+            double r=q[k]/p[k];
+            if (p[k]<0) {
+                s0=fmax(s0,r);
+            } else {
+                s1=fmin(s1,r);
+            }
+        }
+    }
+    return s0<s1;
+}
+
+QVector<Vector2D> toVertices(const QVector<Point> &poly) {
+    QVector<Vector2D> result;
+    if (poly.size()<3) return result;
+    for (auto &p:poly) {
+        result.push_back(Vector2D(p.x,p.y));
+    }
+    return result;
+}
+}
+
+VoronoiDiagram::VoronoiDiagram(const TriangleMesh &p_mesh):mesh(p_mesh) {
+    int T=mesh.getNbTriangles();
+    tabCenters.resize(2*T);
+    for (int t=0; t<T; t++) {
+        const Vector2D &A=mesh.getVertex(mesh.getVertexId(t,0));
+        const Vector2D &B=mesh.getVertex(mesh.getVertexId(t,1));
+        const Vector2D &C=mesh.getVertex(mesh.getVertexId(t,2));
+        // circumcenter relative to A
+        double bx=double(B.x)-A.x, by=double(B.y)-A.y;
+        double cx=double(C.x)-A.x, cy=double(C.y)-A.y;
+        double d=2.0*(bx*cy-by*cx);
+        double b2=bx*bx+by*by, c2=cx*cx+cy*cy;
+        tabCenters[2*t]=A.x+(cy*b2-by*c2)/d;
+        tabCenters[2*t+1]=A.y+(bx*c2-cx*b2)/d;
+    }
+}
+
+QVector<Vector2D> VoronoiDiagram::getCell(int v) const {
+    if (mesh.getNbTriangles()==0) return getCellByBisectors(v);
+    QVector<int> fan=mesh.getFan(v);
+    if (fan.isEmpty()) return QVector<Vector2D>();
+
+    // position of v in triangle #t, edge #k leaves v and edge #(k+2)%3 comes to v
+    auto indexOf=[this,v](int t) {
+        int k=0;
+        while (mesh.getVertexId(t,k)!=v) k++;
+        return k;
+    };
+    int first=fan.first(), last=fan.last();
+    bool onHull=(mesh.getNeighbour(first,indexOf(first))==-1);
+
+    // circumcenters in CCW order
+    QVector<Point> poly;
+    for (int t:fan) {
+        poly.push_back({tabCenters[2*t],tabCenters[2*t+1]});
+    }
+
+    const Vector2D &V=mesh.getVertex(v);
+    double x0=mesh.getWindowXmin(),y0=mesh.getWindowYmin();
+    double x1=mesh.getWindowXmax(),y1=mesh.getWindowYmax();
+    if (onHull) {
+        // hull edges (v,a) of the first triangle and (b,v) of the last one
+        const Vector2D &A=mesh.getVertex(mesh.getVertexId(first,(indexOf(first)+1)%3));
+        const Vector2D &B=mesh.getVertex(mesh.getVertexId(last,(indexOf(last)+2)%3));
+        double ax=double(A.x)-V.x, ay=double(A.y)-V.y, la=sqrt(ax*ax+ay*ay);
+        double bx=double(V.x)-B.x, by=double(V.y)-B.y, lb=sqrt(bx*bx+by*by);
+        // outer normals of the hull edges = directions of the infinite Voronoï edges
+        Point n1={ay/la,-ax/la}, n2={by/lb,-bx/lb};
+        Point m={n1.x+n2.x,n1.y+n2.y};
+        double lm=sqrt(m.x*m.x+m.y*m.y);
+        if (lm<0.5) { // very sharp hull vertex, the normals are nearly opposite
+            m={-ax/la+bx/lb,-ay/la+by/lb};
+            lm=sqrt(m.x*m.x+m.y*m.y);
+        }
+        m.x/=lm;
+        m.y/=lm;
+        // far enough to contain the window part of the area
+        double R=2.0*((x1-x0)+(y1-y0));
+        for (auto &p:poly) {
+            R=fmax(R,2.0*(fabs(p.x-V.x)+fabs(p.y-V.y)));
+        }
+        Point cFirst=poly.first(),cLast=poly.last();
+        poly.push_back({cLast.x+R*n2.x,cLast.y+R*n2.y});
+        poly.push_back({V.x+R*m.x,V.y+R*m.y});
+        poly.push_back({cFirst.x+R*n1.x,cFirst.y+R*n1.y});
+    }
+    poly=clipHalfPlane(poly,-1,0,-x0);
+    poly=clipHalfPlane(poly,1,0,x1);
+    poly=clipHalfPlane(poly,0,-1,-y0);
+    poly=clipHalfPlane(poly,0,1,y1);
+    return toVertices(poly);
+}
+
+QVector<Vector2D> VoronoiDiagram::getCellByBisectors(int v) const {
+    double x0=mesh.getWindowXmin(),y0=mesh.getWindowYmin();
+    double x1=mesh.getWindowXmax(),y1=mesh.getWindowYmax();
+    QVector<Point> poly={{x0,y0},{x1,y0},{x1,y1},{x0,y1}};
+    const Vector2D &V=mesh.getVertex(v);
+    for (int i=0; i<mesh.getNbVertices() && !poly.isEmpty(); i++) {
+        const Vector2D &O=mesh.getVertex(i);
+        if (O==V) {
+            // the first server at this position gets the area
+            if (i<v) return QVector<Vector2D>();
+            continue;
+        }
+        // points closer to V than to O: (O-V).P <= (|O|²-|V|²)/2
+        double a=double(O.x)-V.x, b=double(O.y)-V.y;
+        double c=0.5*((double(O.x)*O.x+double(O.y)*O.y)-(double(V.x)*V.x+double(V.y)*V.y));
+        poly=clipHalfPlane(poly,a,b,c);
+    }
+    return toVertices(poly);
+}
+
+void VoronoiDiagram::fillArea(Server &server,int v) const {
+    server.area=Polygon();
+    QVector<Vector2D> cell=getCell(v);
+    if (cell.isEmpty()) {
+        qWarning() << "No Voronoï area for server" << server.name;
+        return;
+    }
+    for (auto &pt:cell) {
+        server.area.addVertex(pt);
+    }
+    server.area.triangulate();
+}
+
+void VoronoiDiagram::fillAreas(QList<Server> &servers) const {
+    // each area only reads the mesh and writes its own server: the result
+    // does not depend on the number of threads
+    QVector<int> indices(servers.size());
+    std::iota(indices.begin(),indices.end(),0);
+    servers.detach(); // no copy on write from the worker threads
+    QtConcurrent::blockingMap(indices,[this,&servers](int i) {
+        fillArea(servers[i],i);
+    });
+}
+
+QList<Link*> VoronoiDiagram::createLinks(QList<Server> &servers) const {
+    QList<Link*> links;
+    double x0=mesh.getWindowXmin(),y0=mesh.getWindowYmin();
+    double x1=mesh.getWindowXmax(),y1=mesh.getWindowYmax();
+    // link between servers #a and #b through the part [s0,s1] of the line P+s.D
+    auto addLink=[&](int a,int b,const Point &P,const Point &D,double s0,double s1) {
+        if (!clipLine(P,D,s0,s1,x0,y0,x1,y1)) return;
+        if ((s1-s0)*sqrt(D.x*D.x+D.y*D.y)<minEdgeLength) return; // areas touching at a corner
+        QPair<Vector2D,Vector2D> edge(Vector2D(P.x+s0*D.x,P.y+s0*D.y),Vector2D(P.x+s1*D.x,P.y+s1*D.y));
+        Link *l=new Link(&servers[a],&servers[b],edge);
+        links.push_back(l);
+        servers[a].links.push_back(l);
+        servers[b].links.push_back(l);
+    };
+
+    if (mesh.getNbTriangles()==0) {
+        // aligned servers: each one is linked to the next one along the line
+        // by the bisector of their positions
+        QVector<int> order;
+        for (int v=0; v<mesh.getNbVertices(); v++) order.push_back(v);
+        if (order.size()<2) return links;
+        const Vector2D &O=mesh.getVertex(0);
+        Vector2D dir;
+        for (int v=1; v<mesh.getNbVertices() && dir==Vector2D(); v++) dir=mesh.getVertex(v)-O;
+        std::sort(order.begin(),order.end(),[this,&O,&dir](int a,int b) {
+            return (mesh.getVertex(a)-O)*dir<(mesh.getVertex(b)-O)*dir;
+        });
+        for (int k=1; k<order.size(); k++) {
+            const Vector2D &A=mesh.getVertex(order[k-1]), &B=mesh.getVertex(order[k]);
+            if (A==B) { // duplicate position: only the first server has an area
+                order[k]=order[k-1];
+                continue;
+            }
+            Point M={0.5*(double(A.x)+B.x),0.5*(double(A.y)+B.y)};
+            addLink(order[k-1],order[k],M,{double(A.y)-B.y,double(B.x)-A.x},-HUGE_VAL,HUGE_VAL);
+        }
+        return links;
+    }
+
+    // each edge of the mesh is dual of the Voronoï edge between the circumcenters of its two triangles
+    for (int t=0; t<mesh.getNbTriangles(); t++) {
+        for (int i=0; i<3; i++) {
+            int n=mesh.getNeighbour(t,i);
+            if (n!=-1 && n<t) continue; // already seen from triangle #n
+            int a=mesh.getVertexId(t,i), b=mesh.getVertexId(t,(i+1)%3);
+            Point P={tabCenters[2*t],tabCenters[2*t+1]};
+            if (n!=-1) {
+                Point D={tabCenters[2*n]-P.x,tabCenters[2*n+1]-P.y};
+                addLink(a,b,P,D,0,1);
+            } else {
+                // hull edge: infinite Voronoï edge along the outer normal
+                const Vector2D &A=mesh.getVertex(a), &B=mesh.getVertex(b);
+                addLink(a,b,P,{double(B.y)-A.y,double(A.x)-B.x},0,HUGE_VAL);
+            }
+        }
+    }
+    return links;
+}
+
+void buildVoronoiAreasByScan(TriangleMesh &mesh,QList<Server> &servers) {
+    QVector<Triangle> triangles = mesh.getTriangles();
+    auto m_servor = servers.begin();
+    QVector<const Triangle*> tabTri;
+    while (m_servor!=servers.end()) {
+        // for all vertices of the mesh
+        const Vector2D vert((*m_servor).position.x(),(*m_servor).position.y());
+        auto mt_it = triangles.begin();
+        tabTri.clear(); // tabTri: list of triangles containing m_vert
+        while (mt_it!=triangles.end()) {
+            if ((*mt_it).hasVertex(vert)) {
+                tabTri.push_back(&(*mt_it));
+            }
+            mt_it++;
+        }
+        // find left border
+        auto first = tabTri.begin();
+        auto tt_it = tabTri.begin();
+        bool found=false;
+        while (tt_it!=tabTri.end() && !found) {
+            auto comp_it = tabTri.begin();
+            while (comp_it!=tabTri.end() && (*tt_it)->getNextVertex(vert)!=(*comp_it)->getPrevVertex(vert)) {
+                comp_it++;
+            }
+            if (comp_it==tabTri.end()) {
+                first=tt_it;
+                found=true;
+            }
+            tt_it++;
+        }
+        // create polygon
+        tt_it=first;
+        if (found && mesh.isInWindow((*tt_it)->getCenter().x,(*tt_it)->getCenter().y)) { // add a point for the left border
+            Vector2D V = (*first)->nextEdgeNormal(vert);
+            float k;
+            if (V.x > 0) { // (circumCenter+k V).x=width
+                k = (mesh.getWindowXmax() - (*first)->getCenter().x) / float(V.x);
+            } else {
+                k = (mesh.getWindowXmin()-(*first)->getCenter().x) / float(V.x);
+            }
+            if (V.y > 0) { // (circumCenter+k V).y=height
+                k = fmin(k, (mesh.getWindowYmax() - (*first)->getCenter().y) / float(V.y));
+            } else {
+                k = fmin(k, (mesh.getWindowYmin()-(*first)->getCenter().y) / float(V.y));
+            }
+            m_servor->area.addVertex(Vector2D((*first)->getCenter() + k * V));
+        }
+        auto comp_it = first;
+        do {
+            m_servor->area.addVertex((*tt_it)->getCenter());
+            // search triangle on right of tt_it
+            comp_it = tabTri.begin();
+            while (comp_it!=tabTri.end() && (*tt_it)->getPrevVertex(vert)!=(*comp_it)->getNextVertex(vert)) {
+                comp_it++;
+            }
+            if (comp_it!=tabTri.end()) tt_it = comp_it;
+        } while (tt_it!=first && comp_it!=tabTri.end());
+        if (found && mesh.isInWindow((*tt_it)->getCenter())) { // add a point for the right border
+            Vector2D V = (*tt_it)->previousEdgeNormal(vert);
+            float k;
+            if (V.x > 0) { // (circumCenter+k V).x=width
+                k = (mesh.getWindowXmax() - (*tt_it)->getCenter().x) / float(V.x);
+            } else {
+                k = (mesh.getWindowXmin()-(*tt_it)->getCenter().x) / float(V.x);
+            }
+            if (V.y > 0) { // (circumCenter+k V).y=height
+                k = fmin(k, (mesh.getWindowYmax() - (*tt_it)->getCenter().y) / float(V.y));
+            } else {
+                k = fmin(k, (mesh.getWindowYmin()-(*tt_it)->getCenter().y) / float(V.y));
+            }
+            m_servor->area.addVertex(Vector2D((*tt_it)->getCenter() + k * V));
+        }
+        m_servor->area.clip(mesh.getWindowXmin(),mesh.getWindowYmin(),mesh.getWindowXmax(),mesh.getWindowYmax());
+        m_servor->area.triangulate();
+
+        m_servor++;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef VORONOI_H
+#define VORONOI_H
+
+#include <trianglemesh.h>
+
+/**
+ * @brief The VoronoiDiagram class builds the Voronoï areas of the servers
+ * directly from the neighbours of the Delaunay mesh.
+ *
+ * The area of a server is the polygon of the circumcenters of the triangles
+ * around its vertex, visited in CCW order through the neighbour links.
+ * The areas of the servers on the convex hull are closed far away along the
+ * bisectors of the hull edges, then every area is clipped to the window.
+ * Once the mesh is built, all the areas are obtained in O(n).
+ */
+class VoronoiDiagram {
+public:
+    static constexpr double minEdgeLength=1e-3; ///< shorter Voronoï edges do not create a link
+    /**
+     * @brief VoronoiDiagram
+     * @param mesh the Delaunay mesh of the servers, its window must be set
+     */
+    VoronoiDiagram(const TriangleMesh &mesh);
+    /**
+     * @brief getCell
+     * @param v index of a server (vertex of the mesh)
+     * @return the CCW vertices of the Voronoï area of the server clipped to
+     * the window, empty if the server is not a vertex of the mesh (duplicate position)
+     */
+    QVector<Vector2D> getCell(int v) const;
+    /**
+     * @brief fillArea: set and triangulate the area of one server
+     * @param server the server to fill
+     * @param v index of the server in the mesh
+     */
+    void fillArea(Server &server,int v) const;
+    /**
+     * @brief fillAreas: set and triangulate the area of each server,
+     * the servers are shared out among the threads of the global pool
+     * @param servers the servers used to build the mesh (same order)
+     */
+    void fillAreas(QList<Server> &servers) const;
+    /**
+     * @brief createLinks: one link for each Delaunay edge whose dual Voronoï edge
+     * crosses the window, the door of the link is this Voronoï edge clipped to the window.
+     * The links are also added to the lists of their two servers.
+     * @param servers the servers used to build the mesh (same order)
+     * @return the new links, in O(n)
+     */
+    QList<Link*> createLinks(QList<Server> &servers) const;
+private:
+    /**
+     * @brief getCellByBisectors: area of vertex #v as the window clipped by the
+     * bisectors with all the other vertices, used when the mesh has no triangle
+     * (less than 3 servers or aligned servers).
+     */
+    QVector<Vector2D> getCellByBisectors(int v) const;
+
+    const TriangleMesh &mesh;
+    QVector<double> tabCenters; ///< circumcenter (x,y) of each triangle, in double precision
+};
+
+/**
+ * @brief buildVoronoiAreasByScan: construction of the Voronoï areas by scanning
+ * the triangles of the mesh for each server (O(n.T)), kept to compare with VoronoiDiagram.
+ */
+void buildVoronoiAreasByScan(TriangleMesh &mesh,QList<Server> &servers);
+
+#endif // VORONOI_H